@@ -6,47 +6,110 @@
 #ifndef COMMONAPI_ADDRESS_HPP_
 #define COMMONAPI_ADDRESS_HPP_
 
+#include <cstddef>
+#include <functional>
 #include <iostream>
 #include <string>
 
 #include <CommonAPI/Export.hpp>
+#include <CommonAPI/StringView.hpp>
 
 namespace CommonAPI {
 
+/**
+ * \brief Address of a service in the form "domain:interface:instance".
+ *
+ * Addresses are interned: all addresses with the same content refer to a
+ * single, process-wide entry that is released with the last address using
+ * it. Copying, comparing for equality and hashing an address therefore do
+ * not touch its strings. Addresses are ordered by domain, interface and
+ * instance.
+ *
+ * An address only holds a pointer to its entry, which changed the size of
+ * the class. Therefore the SOVERSION of the library was increased.
+ */
 class Address {
 public:
-    COMMONAPI_EXPORT Address() = default;
+    COMMONAPI_EXPORT Address();
+    COMMONAPI_EXPORT Address(const char *_address);
     COMMONAPI_EXPORT Address(const std::string &_address);
+    COMMONAPI_EXPORT Address(const StringView &_address);
     COMMONAPI_EXPORT Address(const std::string &_domain,
             const std::string &_interface,
             const std::string &_instance);
+    COMMONAPI_EXPORT Address(const StringView &_domain,
+            const StringView &_interface,
+            const StringView &_instance);
+    Address(const char *_domain, const char *_interface, const char *_instance)
+        : Address(StringView(_domain), StringView(_interface), StringView(_instance)) {
+    }
     COMMONAPI_EXPORT Address(const Address &_source);
     COMMONAPI_EXPORT virtual ~Address();
 
+    COMMONAPI_EXPORT Address &operator=(const Address &_source);
+
     COMMONAPI_EXPORT bool operator==(const Address &_other) const;
     COMMONAPI_EXPORT bool operator!=(const Address &_other) const;
     COMMONAPI_EXPORT bool operator<(const Address &_other) const;
 
     COMMONAPI_EXPORT std::string getAddress() const;
+    /**
+     * \brief Returns the address string without copying it. It stays valid
+     *        as long as the address is neither changed nor destroyed.
+     */
+    COMMONAPI_EXPORT const std::string &getAddressRef() const;
     COMMONAPI_EXPORT void setAddress(const std::string &_address);
+    COMMONAPI_EXPORT void setAddress(const StringView &_address);
+    void setAddress(const char *_address) { setAddress(StringView(_address)); }
 
     COMMONAPI_EXPORT const std::string &getDomain() const;
     COMMONAPI_EXPORT void setDomain(const std::string &_domain);
+    COMMONAPI_EXPORT void setDomain(const StringView &_domain);
+    void setDomain(const char *_domain) { setDomain(StringView(_domain)); }
 
     COMMONAPI_EXPORT const std::string &getInterface() const;
     COMMONAPI_EXPORT void setInterface(const std::string &_interface);
+    COMMONAPI_EXPORT void setInterface(const StringView &_interface);
+    void setInterface(const char *_interface) { setInterface(StringView(_interface)); }
 
     COMMONAPI_EXPORT const std::string &getInstance() const;
     COMMONAPI_EXPORT void setInstance(const std::string &_instance);
+    COMMONAPI_EXPORT void setInstance(const StringView &_instance);
+    void setInstance(const char *_instance) { setInstance(StringView(_instance)); }
+
+    /**
+     * \brief Returns the hash of the address string. It does not depend on
+     *        the process.
+     */
+    COMMONAPI_EXPORT std::size_t getHash() const;
 
 private:
-    std::string domain_;
-    std::string interface_;
-    std::string instance_;
+    struct Entry;
+    struct Shard;
+
+    static Shard &getShard(std::size_t _hash);
+    static const Entry *intern(const StringView &_domain,
+                               const StringView &_interface,
+                               const StringView &_instance);
+    static void acquire(const Entry *_entry);
+    static void release(const Entry *_entry);
+
+    const Entry *entry_;
 
     friend COMMONAPI_EXPORT std::ostream &operator<<(std::ostream &_out, const Address &_address);
 };
 
 } // namespace CommonAPI
 
+namespace std {
+
+template<>
+struct hash<CommonAPI::Address> {
+    std::size_t operator()(const CommonAPI::Address &_address) const {
+        return _address.getHash();
+    }
+};
+
+} // namespace std
+
 #endif // COMMONAPI_ADDRESS_HPP_
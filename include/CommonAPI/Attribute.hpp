@@ -17,10 +17,44 @@
 
 #include <CommonAPI/CallInfo.hpp>
 #include <CommonAPI/Event.hpp>
+#include <CommonAPI/Future.hpp>
 #include <CommonAPI/Types.hpp>
 
 namespace CommonAPI {
 
+/**
+ * \brief Implemented additionally to ReadonlyAttribute by the attributes of
+ *        bindings that fulfill a CommonAPI::Future directly.
+ *
+ * ReadonlyAttribute::getValueAsyncLight looks it up. It is kept apart to
+ * leave the vtable of ReadonlyAttribute unchanged.
+ */
+template <typename ValueType_>
+class ReadonlyAttributeLightSupport {
+ public:
+    virtual ~ReadonlyAttributeLightSupport() { }
+
+    virtual Future<CallStatus> getValueAsyncLight(std::function<void(const CallStatus &, ValueType_)> _callback,
+                                                  const CallInfo *_info) = 0;
+};
+
+/**
+ * \brief Implemented additionally to Attribute by the attributes of
+ *        bindings that fulfill a CommonAPI::Future directly.
+ *
+ * Attribute::setValueAsyncLight looks it up. It is kept apart to leave the
+ * vtable of Attribute unchanged.
+ */
+template <typename ValueType_>
+class AttributeLightSupport {
+ public:
+    virtual ~AttributeLightSupport() { }
+
+    virtual Future<CallStatus> setValueAsyncLight(const ValueType_ &_value,
+                                                  std::function<void(const CallStatus &, ValueType_)> _callback,
+                                                  const CallInfo *_info) = 0;
+};
+
 /**
  * \brief Class representing a read only attribute
  *
@@ -57,6 +91,36 @@ class ReadonlyAttribute {
      */
     virtual std::future<CallStatus> getValueAsync(AttributeAsyncCallback attributeAsyncCallback,
                                                   const CallInfo *_info = nullptr) = 0;
+
+    /**
+     * \brief Get value of attribute, usually from remote. Asynchronous call.
+     *
+     * Same as above, but returns a CommonAPI::Future. Attributes that
+     * implement ReadonlyAttributeLightSupport fulfill it directly. For all
+     * others the std::future based call is adapted, which is not cheaper
+     * than that call.
+     *
+     * @param attributeAsyncCallback std::function object for the callback to be invoked.
+     * @return CommonAPI::Future containing the call status of the operation.
+     */
+    Future<CallStatus> getValueAsyncLight(AttributeAsyncCallback attributeAsyncCallback,
+                                          const CallInfo *_info = nullptr) {
+        ReadonlyAttributeLightSupport<ValueType_> *support
+            = dynamic_cast<ReadonlyAttributeLightSupport<ValueType_> *>(this);
+        if (support)
+            return support->getValueAsyncLight(attributeAsyncCallback, _info);
+
+        Promise<CallStatus> promise;
+        Future<CallStatus> future = promise.getFuture();
+        (void)getValueAsync(
+            [attributeAsyncCallback, promise](const CallStatus &_status, ValueType_ _value) mutable {
+                if (attributeAsyncCallback)
+                    attributeAsyncCallback(_status, _value);
+                promise.setValue(_status);
+            },
+            _info);
+        return future;
+    }
 };
 
 /**
@@ -98,6 +162,39 @@ class Attribute: public ReadonlyAttribute<ValueType_> {
     virtual std::future<CallStatus> setValueAsync(const ValueType_& requestValue,
                                                   AttributeAsyncCallback attributeAsyncCallback,
                                                   const CallInfo *_info = nullptr) = 0;
+
+    /**
+     * \brief Set value of attribute, usually to remote. Asynchronous call.
+     *
+     * Same as above, but returns a CommonAPI::Future. Attributes that
+     * implement AttributeLightSupport fulfill it directly. For all others
+     * the std::future based call is adapted, which is not cheaper than that
+     * call.
+     *
+     * @param requestValue Value to be set
+     * @param attributeAsyncCallback std::function object for the callback to be invoked.
+     * @return CommonAPI::Future containing the call status of the operation.
+     */
+    Future<CallStatus> setValueAsyncLight(const ValueType_& requestValue,
+                                          AttributeAsyncCallback attributeAsyncCallback,
+                                          const CallInfo *_info = nullptr) {
+        AttributeLightSupport<ValueType_> *support
+            = dynamic_cast<AttributeLightSupport<ValueType_> *>(this);
+        if (support)
+            return support->setValueAsyncLight(requestValue, attributeAsyncCallback, _info);
+
+        Promise<CallStatus> promise;
+        Future<CallStatus> future = promise.getFuture();
+        (void)setValueAsync(
+            requestValue,
+            [attributeAsyncCallback, promise](const CallStatus &_status, ValueType_ _value) mutable {
+                if (attributeAsyncCallback)
+                    attributeAsyncCallback(_status, _value);
+                promise.setValue(_status);
+            },
+            _info);
+        return future;
+    }
 };
 
 /**
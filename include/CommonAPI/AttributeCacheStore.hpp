@@ -0,0 +1,103 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_ATTRIBUTECACHESTORE_HPP_
+#define COMMONAPI_ATTRIBUTECACHESTORE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <CommonAPI/ByteBuffer.hpp>
+#include <CommonAPI/Export.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Persists serialized attribute values across restarts.
+ *
+ * The store keeps one serialized value per key, usually the address of a
+ * proxy and the name of an attribute. Opening a store maps its file and
+ * reads the values saved by a previous run. Cached attributes attach a
+ * source, which is asked for the current value whenever the store is
+ * saved, so that updates do not need to be serialized when they occur.
+ * The store is saved on destruction and whenever save() is called, for
+ * example periodically from a main loop timeout.
+ */
+class AttributeCacheStore {
+public:
+    /**
+     * \brief Serializes the current value into the buffer. Returns false if
+     *        there is no value. Called with the store locked, a source must
+     *        not call the store.
+     */
+    typedef std::function<bool(ByteBuffer &)> Source;
+
+    /**
+     * \brief Identifies an attached source. Never 0.
+     */
+    typedef uint64_t SourceId;
+
+    /**
+     * \brief Opens the store at _path. A missing or invalid file results in
+     *        an empty store.
+     */
+    COMMONAPI_EXPORT static std::shared_ptr<AttributeCacheStore> open(const std::string &_path);
+
+    COMMONAPI_EXPORT ~AttributeCacheStore();
+
+    AttributeCacheStore(const AttributeCacheStore &) = delete;
+    AttributeCacheStore &operator=(const AttributeCacheStore &) = delete;
+
+    COMMONAPI_EXPORT bool get(const std::string &_key, ByteBuffer &_value) const;
+    COMMONAPI_EXPORT void put(const std::string &_key, const ByteBuffer &_value);
+
+    /**
+     * \brief Attaches a source of a key. A key may have several sources,
+     *        the value of the one attached last is saved.
+     */
+    COMMONAPI_EXPORT SourceId attach(const std::string &_key, Source _source);
+
+    /**
+     * \brief Detaches a source after taking its current value. Other
+     *        sources of the same key stay attached.
+     */
+    COMMONAPI_EXPORT void detach(SourceId _source);
+
+    /**
+     * \brief Writes all values to the file. The file is replaced atomically
+     *        by a complete, synced file. Concurrent saves are serialized.
+     */
+    COMMONAPI_EXPORT bool save();
+
+private:
+    AttributeCacheStore(const std::string &_path);
+
+    void load();
+    void collect();
+
+    std::string path_;
+
+    // Held while a save writes the file, without blocking get and put
+    std::mutex saveMutex_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ByteBuffer> values_;
+    // Ordered by attachment, the last source of a key is collected last
+    std::map<SourceId, std::pair<std::string, Source>> sources_;
+    SourceId nextSourceId_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_ATTRIBUTECACHESTORE_HPP_
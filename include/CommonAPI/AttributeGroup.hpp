@@ -0,0 +1,283 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_ATTRIBUTEGROUP_HPP_
+#define COMMONAPI_ATTRIBUTEGROUP_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <CommonAPI/Attribute.hpp>
+#include <CommonAPI/CallInfo.hpp>
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/Future.hpp>
+#include <CommonAPI/Proxy.hpp>
+#include <CommonAPI/Types.hpp>
+
+namespace CommonAPI {
+
+class AttributeRequest;
+
+template<typename Value_>
+class AttributeGetRequest;
+template<typename Value_>
+class AttributeSetRequest;
+
+/**
+ * \brief Implemented by bindings that transport the requests of an
+ *        AttributeGroup in a single message.
+ *
+ * A batch recognizes the requests for its own attributes by asking each of
+ * them with AttributeRequest::asGet() and asSet(), which only return the
+ * typed request if it refers to the given attribute with its value type.
+ * Each request taken must be completed exactly once, also if the message
+ * fails.
+ */
+class AttributeBatch {
+public:
+    virtual ~AttributeBatch() {}
+
+    /**
+     * \brief Takes a request for the next message. Returns false if the
+     *        attribute cannot be batched, it is then requested separately.
+     */
+    virtual bool add(const std::shared_ptr<AttributeRequest> &_request) = 0;
+
+    /**
+     * \brief Sends the requests taken since the last call.
+     */
+    virtual void send(const CallInfo *_info) = 0;
+};
+
+/**
+ * \brief Implemented additionally to Proxy by the proxies of bindings that
+ *        provide an AttributeBatch. AttributeGroup looks it up, the Proxy
+ *        interface itself is not extended.
+ */
+class AttributeBatchSupport {
+public:
+    virtual ~AttributeBatchSupport() {}
+
+    virtual std::shared_ptr<AttributeBatch> createAttributeBatch() = 0;
+};
+
+/**
+ * \brief Gets and sets several attributes with a single completion.
+ *
+ * The requests of a group are handed to the AttributeBatch of the binding,
+ * if there is one, and all remaining requests are issued at once without
+ * waiting for each other. The future returned by send() is fulfilled when
+ * all requests completed, with SUCCESS or the status of the first failed
+ * request in the order the requests were added. A group can be sent
+ * repeatedly, but not again before the previous send completed.
+ */
+class AttributeGroup {
+public:
+    COMMONAPI_EXPORT AttributeGroup(std::shared_ptr<AttributeBatch> _batch = nullptr);
+
+    /**
+     * \brief Creates a group using the batch of the proxy's binding, if its
+     *        proxies implement AttributeBatchSupport.
+     */
+    COMMONAPI_EXPORT AttributeGroup(Proxy &_proxy);
+
+    COMMONAPI_EXPORT ~AttributeGroup();
+
+    AttributeGroup(const AttributeGroup &) = delete;
+    AttributeGroup &operator=(const AttributeGroup &) = delete;
+
+    /**
+     * \brief Adds reading an attribute into _value, which must stay valid
+     *        until the group completed. Returns the index of the request.
+     */
+    template<typename Value_>
+    std::size_t get(ReadonlyAttribute<Value_> &_attribute, Value_ &_value);
+
+    /**
+     * \brief Adds writing _value to an attribute. Returns the index of the
+     *        request.
+     */
+    template<typename Value_>
+    std::size_t set(Attribute<Value_> &_attribute, const Value_ &_value);
+
+    COMMONAPI_EXPORT std::size_t size() const;
+
+    COMMONAPI_EXPORT Future<CallStatus> send(const CallInfo *_info = nullptr);
+
+    /**
+     * \brief Returns the status of a request of the last completed send.
+     */
+    COMMONAPI_EXPORT CallStatus getCallStatus(std::size_t _index) const;
+
+private:
+    struct Completion;
+
+    COMMONAPI_EXPORT std::size_t add(std::shared_ptr<AttributeRequest> _request);
+
+    std::shared_ptr<AttributeBatch> batch_;
+    std::vector<std::shared_ptr<AttributeRequest>> requests_;
+    std::shared_ptr<Completion> completion_;
+
+friend class AttributeRequest;
+};
+
+/**
+ * \brief A single request of an AttributeGroup.
+ */
+class AttributeRequest : public std::enable_shared_from_this<AttributeRequest> {
+public:
+    COMMONAPI_EXPORT virtual ~AttributeRequest();
+
+    bool isSet() const {
+        return isSet_;
+    }
+
+    /**
+     * \brief Returns this request if it reads _attribute, else nullptr.
+     */
+    template<typename Value_>
+    std::shared_ptr<AttributeGetRequest<Value_>> asGet(const ReadonlyAttribute<Value_> &_attribute);
+
+    /**
+     * \brief Returns this request if it writes _attribute, else nullptr.
+     */
+    template<typename Value_>
+    std::shared_ptr<AttributeSetRequest<Value_>> asSet(const Attribute<Value_> &_attribute);
+
+protected:
+    COMMONAPI_EXPORT AttributeRequest(bool _isSet);
+
+    /**
+     * \brief Records the status of the request and fulfills the group
+     *        future once all requests of the group completed.
+     */
+    COMMONAPI_EXPORT void complete(const CallStatus &_status);
+
+private:
+    /**
+     * \brief Issues the request by itself, if no batch took it.
+     */
+    virtual void send(const CallInfo *_info) = 0;
+
+    bool isSet_;
+
+    std::shared_ptr<AttributeGroup::Completion> completion_;
+    std::size_t index_;
+
+friend class AttributeGroup;
+};
+
+template<typename Value_>
+class AttributeGetRequest : public AttributeRequest {
+public:
+    AttributeGetRequest(ReadonlyAttribute<Value_> &_attribute, Value_ &_value)
+        : AttributeRequest(false),
+          attribute_(_attribute), value_(_value) {
+    }
+
+    bool refersTo(const ReadonlyAttribute<Value_> &_attribute) const {
+        return (&attribute_ == &_attribute);
+    }
+
+    /**
+     * \brief Completes the request with the value read.
+     */
+    void setValue(const CallStatus &_status, const Value_ &_value) {
+        if (_status == CallStatus::SUCCESS)
+            value_ = _value;
+        complete(_status);
+    }
+
+private:
+    void send(const CallInfo *_info) {
+        std::shared_ptr<AttributeGetRequest> itsRequest
+            = std::static_pointer_cast<AttributeGetRequest>(shared_from_this());
+        (void)attribute_.getValueAsyncLight(
+            [itsRequest](const CallStatus &_status, Value_ _value) {
+                itsRequest->setValue(_status, _value);
+            },
+            _info);
+    }
+
+    ReadonlyAttribute<Value_> &attribute_;
+    Value_ &value_;
+};
+
+template<typename Value_>
+class AttributeSetRequest : public AttributeRequest {
+public:
+    AttributeSetRequest(Attribute<Value_> &_attribute, const Value_ &_value)
+        : AttributeRequest(true),
+          attribute_(_attribute), value_(_value) {
+    }
+
+    bool refersTo(const Attribute<Value_> &_attribute) const {
+        return (&attribute_ == &_attribute);
+    }
+
+    const Value_ &getValue() const {
+        return value_;
+    }
+
+    /**
+     * \brief Completes the request.
+     */
+    void setResponse(const CallStatus &_status) {
+        complete(_status);
+    }
+
+private:
+    void send(const CallInfo *_info) {
+        std::shared_ptr<AttributeSetRequest> itsRequest
+            = std::static_pointer_cast<AttributeSetRequest>(shared_from_this());
+        (void)attribute_.setValueAsyncLight(
+            value_,
+            [itsRequest](const CallStatus &_status, Value_) {
+                itsRequest->setResponse(_status);
+            },
+            _info);
+    }
+
+    Attribute<Value_> &attribute_;
+    Value_ value_;
+};
+
+// The value type is checked by the cast, the attribute by its address
+template<typename Value_>
+std::shared_ptr<AttributeGetRequest<Value_>>
+AttributeRequest::asGet(const ReadonlyAttribute<Value_> &_attribute) {
+    std::shared_ptr<AttributeGetRequest<Value_>> itsRequest
+        = std::dynamic_pointer_cast<AttributeGetRequest<Value_>>(shared_from_this());
+    return (itsRequest && itsRequest->refersTo(_attribute) ? itsRequest : nullptr);
+}
+
+template<typename Value_>
+std::shared_ptr<AttributeSetRequest<Value_>>
+AttributeRequest::asSet(const Attribute<Value_> &_attribute) {
+    std::shared_ptr<AttributeSetRequest<Value_>> itsRequest
+        = std::dynamic_pointer_cast<AttributeSetRequest<Value_>>(shared_from_this());
+    return (itsRequest && itsRequest->refersTo(_attribute) ? itsRequest : nullptr);
+}
+
+template<typename Value_>
+std::size_t
+AttributeGroup::get(ReadonlyAttribute<Value_> &_attribute, Value_ &_value) {
+    return add(std::make_shared<AttributeGetRequest<Value_>>(_attribute, _value));
+}
+
+template<typename Value_>
+std::size_t
+AttributeGroup::set(Attribute<Value_> &_attribute, const Value_ &_value) {
+    return add(std::make_shared<AttributeSetRequest<Value_>>(_attribute, _value));
+}
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_ATTRIBUTEGROUP_HPP_
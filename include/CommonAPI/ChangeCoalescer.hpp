@@ -0,0 +1,138 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_CHANGECOALESCER_HPP_
+#define COMMONAPI_CHANGECOALESCER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <CommonAPI/MainLoopContext.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Coalesces the change notifications of an attribute.
+ *
+ * Stub adapters pass each new value to update() instead of notifying it
+ * directly. The coalescer keeps the latest value and publishes it from the
+ * main loop once the window has passed since the first unpublished update,
+ * or, with a window of zero, at the end of the current main loop
+ * iteration. Intermediate values are never published, and a value is
+ * published at most one window after it was set, also under continuous
+ * updates.
+ *
+ * update() may be called from any thread. The publish function is called
+ * from the main loop, without any lock held. A value still pending when the
+ * coalescer is destroyed is dropped, call flush() to publish it.
+ */
+template<typename Value_>
+class ChangeCoalescer : private DispatchSource {
+public:
+    typedef std::function<void(const Value_ &)> PublishFunction;
+
+    ChangeCoalescer(std::shared_ptr<MainLoopContext> _context,
+                    std::chrono::milliseconds _window,
+                    PublishFunction _publish)
+        : context_(_context),
+          window_(_window.count()),
+          publish_(_publish),
+          isPending_(false),
+          deadline_(0) {
+        context_->registerDispatchSource(this);
+    }
+
+    ~ChangeCoalescer() {
+        context_->deregisterDispatchSource(this);
+    }
+
+    ChangeCoalescer(const ChangeCoalescer &) = delete;
+    ChangeCoalescer &operator=(const ChangeCoalescer &) = delete;
+
+    /**
+     * \brief Sets the value to be published, replacing a pending one.
+     */
+    void update(const Value_ &_value) {
+        bool wasPending;
+        {
+            std::lock_guard<std::mutex> itsLock(mutex_);
+            value_ = _value;
+            wasPending = isPending_;
+            if (!isPending_) {
+                isPending_ = true;
+                deadline_ = getCurrentTimeInMs() + window_;
+            }
+        }
+        // The main loop must recompute its timeout for the new deadline
+        if (!wasPending)
+            context_->wakeup();
+    }
+
+    bool isPending() const {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        return isPending_;
+    }
+
+    /**
+     * \brief Publishes the pending value immediately, from the calling
+     *        thread. Returns false if there was none.
+     */
+    bool flush() {
+        Value_ itsValue;
+        {
+            std::lock_guard<std::mutex> itsLock(mutex_);
+            if (!isPending_)
+                return false;
+            itsValue = value_;
+            isPending_ = false;
+        }
+        publish_(itsValue);
+        return true;
+    }
+
+private:
+    bool prepare(int64_t &_timeout) {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        if (!isPending_) {
+            _timeout = TIMEOUT_INFINITE;
+            return false;
+        }
+        int64_t itsRemaining = deadline_ - getCurrentTimeInMs();
+        if (itsRemaining <= 0)
+            return true;
+        _timeout = itsRemaining;
+        return false;
+    }
+
+    bool check() {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        return (isPending_ && getCurrentTimeInMs() >= deadline_);
+    }
+
+    bool dispatch() {
+        (void)flush();
+        return false;
+    }
+
+    std::shared_ptr<MainLoopContext> context_;
+    int64_t window_;
+    PublishFunction publish_;
+
+    mutable std::mutex mutex_;
+    Value_ value_;
+    bool isPending_;
+    int64_t deadline_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_CHANGECOALESCER_HPP_
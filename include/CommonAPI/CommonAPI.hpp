@@ -12,10 +12,17 @@
 
 #include "Address.hpp"
 #include "Attribute.hpp"
+#include "AttributeCacheStore.hpp"
 #include "AttributeExtension.hpp"
+#include "AttributeGroup.hpp"
 #include "ByteBuffer.hpp"
+#include "ChangeCoalescer.hpp"
+#include "Delta.hpp"
+#include "Executor.hpp"
+#include "LocalFactory.hpp"
 #include "MainLoopContext.hpp"
 #include "Runtime.hpp"
+#include "ShmFactory.hpp"
 #include "Types.hpp"
 
 #undef COMMONAPI_INTERNAL_COMPILATION
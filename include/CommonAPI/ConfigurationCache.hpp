@@ -0,0 +1,99 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef COMMONAPI_CONFIGURATIONCACHE_HPP_
+#define COMMONAPI_CONFIGURATIONCACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/IniFileReader.hpp>
+#include <CommonAPI/StringView.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Compiled, memory mapped form of an ini file.
+ *
+ * The cache contains the sections and their keys sorted by name, the
+ * strings they refer to and a perfect hash index over section and key.
+ * Values are therefore found with two hash computations and without
+ * parsing. The cache remembers size and modification time of the ini file
+ * it was compiled from and is only used as long as these did not change.
+ */
+class ConfigurationCache {
+public:
+    typedef std::function<void(const StringView &, const StringView &)> MappingHandler;
+
+    /**
+     * \brief Maps the cache at _path if it is up to date with the ini file
+     *        at _source. Otherwise, the ini file is compiled and the cache
+     *        is written first. Returns nullptr on failure.
+     */
+    COMMONAPI_EXPORT static std::shared_ptr<const ConfigurationCache> open(const std::string &_path,
+                                                                           const std::string &_source);
+
+    /**
+     * \brief Compiles the ini file that was loaded by _reader, with the
+     *        status _source it had when it was read, into a cache at _path.
+     *        Nothing is written if _source is invalid. The cache is written
+     *        to a new file that replaces the old one, which stays intact for
+     *        its readers.
+     */
+    COMMONAPI_EXPORT static bool write(const std::string &_path,
+                                       const IniFileReader::FileStatus &_source,
+                                       const IniFileReader &_reader);
+
+    COMMONAPI_EXPORT ~ConfigurationCache();
+
+    ConfigurationCache(const ConfigurationCache &) = delete;
+    ConfigurationCache &operator=(const ConfigurationCache &) = delete;
+
+    COMMONAPI_EXPORT bool hasSection(const StringView &_section) const;
+
+    /**
+     * \brief Looks up the value of a key. The returned value refers to the
+     *        mapped memory and is valid as long as the cache exists.
+     */
+    COMMONAPI_EXPORT bool find(const StringView &_section, const StringView &_key,
+                               StringView &_value) const;
+
+    /**
+     * \brief Calls _handler with key and value of all keys of a section.
+     */
+    COMMONAPI_EXPORT void forEach(const StringView &_section, const MappingHandler &_handler) const;
+
+private:
+    struct Header;
+    struct Section;
+    struct Entry;
+
+    ConfigurationCache(const void *_memory, std::size_t _size);
+
+    static std::shared_ptr<const ConfigurationCache> map(const std::string &_path,
+                                                         const std::string &_source);
+
+    bool isValid() const;
+    const Section *findSection(const StringView &_section) const;
+    StringView getString(uint32_t _offset, uint32_t _size) const;
+
+    const void *memory_;
+    std::size_t size_;
+
+    const Header *header_;
+    const Section *sections_;
+    const Entry *entries_;
+    const uint32_t *seeds_;
+    const uint32_t *slots_;
+    const char *strings_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_CONFIGURATIONCACHE_HPP_
@@ -0,0 +1,402 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_DELTA_HPP_
+#define COMMONAPI_DELTA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <CommonAPI/InputStream.hpp>
+#include <CommonAPI/OutputStream.hpp>
+#include <CommonAPI/Struct.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Changes that turn one vector into another.
+ *
+ * A delta is a sequence of operations, each refers to the vector as left
+ * by the previous one. It is either built explicitly by the stub or
+ * computed from the old and new value. compute() trims the common prefix
+ * and suffix and encodes the remaining range as runs of updated elements
+ * followed by a single insertion or erasure. A delta applies only to a
+ * vector of the size it was built for, otherwise apply() fails and the
+ * receiver must read the full value.
+ *
+ * Deltas are serialized with the stream operators of their members, the
+ * deployment of the elements is not applied.
+ */
+template<typename Element_>
+class VectorDelta {
+public:
+    enum Operation : uint8_t {
+        UPDATE = 0,
+        INSERT = 1,
+        ERASE = 2
+    };
+
+    VectorDelta(std::size_t _sourceSize = 0)
+        : sourceSize_(uint32_t(_sourceSize)) {
+    }
+
+    static VectorDelta compute(const std::vector<Element_> &_source,
+                               const std::vector<Element_> &_target) {
+        VectorDelta itsDelta(_source.size());
+
+        std::size_t itsPrefix(0);
+        std::size_t itsShorter = (_source.size() < _target.size() ? _source.size() : _target.size());
+        while (itsPrefix < itsShorter && _source[itsPrefix] == _target[itsPrefix])
+            itsPrefix++;
+
+        std::size_t itsSuffix(0);
+        while (itsSuffix < itsShorter - itsPrefix
+                && _source[_source.size() - itsSuffix - 1] == _target[_target.size() - itsSuffix - 1])
+            itsSuffix++;
+
+        std::size_t itsSourceEnd = _source.size() - itsSuffix;
+        std::size_t itsTargetEnd = _target.size() - itsSuffix;
+        std::size_t itsOverlap = itsPrefix + (itsShorter - itsPrefix - itsSuffix);
+
+        for (std::size_t i = itsPrefix; i < itsOverlap; i++) {
+            if (!(_source[i] == _target[i]))
+                itsDelta.update(i, _target[i]);
+        }
+        if (itsTargetEnd > itsSourceEnd) {
+            itsDelta.insert(itsOverlap, _target.begin() + std::ptrdiff_t(itsOverlap),
+                            _target.begin() + std::ptrdiff_t(itsTargetEnd));
+        } else if (itsSourceEnd > itsTargetEnd) {
+            itsDelta.erase(itsOverlap, itsSourceEnd - itsOverlap);
+        }
+        return itsDelta;
+    }
+
+    void update(std::size_t _index, const Element_ &_value) {
+        add(UPDATE, _index, 1);
+        values_.push_back(_value);
+    }
+
+    void insert(std::size_t _index, const Element_ &_value) {
+        add(INSERT, _index, 1);
+        values_.push_back(_value);
+    }
+
+    template<typename Iterator_>
+    void insert(std::size_t _index, Iterator_ _begin, Iterator_ _end) {
+        std::size_t itsCount = std::size_t(std::distance(_begin, _end));
+        if (0 < itsCount) {
+            add(INSERT, _index, itsCount);
+            values_.insert(values_.end(), _begin, _end);
+        }
+    }
+
+    void erase(std::size_t _index, std::size_t _count = 1) {
+        if (0 < _count)
+            add(ERASE, _index, _count);
+    }
+
+    bool empty() const {
+        return operations_.empty();
+    }
+
+    /**
+     * \brief Applies the delta to _value. Returns false and leaves _value
+     *        unchanged if the delta does not fit.
+     */
+    bool apply(std::vector<Element_> &_value) const {
+        if (!isValid(_value.size()))
+            return false;
+
+        std::size_t itsValue(0);
+        for (std::size_t i = 0; i < operations_.size(); i++) {
+            auto itsPosition = _value.begin() + std::ptrdiff_t(indices_[i]);
+            switch (operations_[i]) {
+            case UPDATE:
+                for (uint32_t j = 0; j < counts_[i]; j++)
+                    *itsPosition++ = values_[itsValue++];
+                break;
+            case INSERT:
+                _value.insert(itsPosition,
+                              values_.begin() + std::ptrdiff_t(itsValue),
+                              values_.begin() + std::ptrdiff_t(itsValue + counts_[i]));
+                itsValue += counts_[i];
+                break;
+            default:
+                _value.erase(itsPosition, itsPosition + std::ptrdiff_t(counts_[i]));
+                break;
+            }
+        }
+        return true;
+    }
+
+    template<class Derived_>
+    void write(OutputStream<Derived_> &_output) const {
+        _output << sourceSize_ << operations_ << indices_ << counts_ << values_;
+    }
+
+    template<class Derived_>
+    void read(InputStream<Derived_> &_input) {
+        _input >> sourceSize_ >> operations_ >> indices_ >> counts_ >> values_;
+    }
+
+private:
+    void add(Operation _operation, std::size_t _index, std::size_t _count) {
+        // Consecutive runs of the same operation are merged
+        std::size_t itsLast = operations_.size() - 1;
+        if (!operations_.empty() && operations_[itsLast] == _operation && _operation != ERASE
+                && indices_[itsLast] + counts_[itsLast] == _index) {
+            counts_[itsLast] += uint32_t(_count);
+            return;
+        }
+        operations_.push_back(_operation);
+        indices_.push_back(uint32_t(_index));
+        counts_.push_back(uint32_t(_count));
+    }
+
+    // Checks the operations against the sizes they are applied to, as a
+    // received delta must not corrupt the value
+    bool isValid(std::size_t _size) const {
+        if (_size != sourceSize_
+                || indices_.size() != operations_.size()
+                || counts_.size() != operations_.size())
+            return false;
+
+        std::size_t itsValues(0);
+        for (std::size_t i = 0; i < operations_.size(); i++) {
+            std::size_t itsIndex(indices_[i]), itsCount(counts_[i]);
+            switch (operations_[i]) {
+            case UPDATE:
+                if (itsIndex + itsCount > _size)
+                    return false;
+                itsValues += itsCount;
+                break;
+            case INSERT:
+                if (itsIndex > _size)
+                    return false;
+                itsValues += itsCount;
+                _size += itsCount;
+                break;
+            case ERASE:
+                if (itsIndex + itsCount > _size)
+                    return false;
+                _size -= itsCount;
+                break;
+            default:
+                return false;
+            }
+        }
+        return (itsValues == values_.size());
+    }
+
+    uint32_t sourceSize_;
+    std::vector<uint8_t> operations_;
+    std::vector<uint32_t> indices_;
+    std::vector<uint32_t> counts_;
+    std::vector<Element_> values_;
+};
+
+/**
+ * \brief Changes that turn one unordered map into another: the erased keys
+ *        and the inserted or updated entries.
+ */
+template<typename Key_, typename Value_, typename Hasher_ = std::hash<Key_>>
+class MapDelta {
+public:
+    typedef std::unordered_map<Key_, Value_, Hasher_> map_t;
+
+    static MapDelta compute(const map_t &_source, const map_t &_target) {
+        MapDelta itsDelta;
+        for (const auto &entry : _source) {
+            if (_target.find(entry.first) == _target.end())
+                itsDelta.erase(entry.first);
+        }
+        for (const auto &entry : _target) {
+            auto itsSource = _source.find(entry.first);
+            if (itsSource == _source.end() || !(itsSource->second == entry.second))
+                itsDelta.update(entry.first, entry.second);
+        }
+        return itsDelta;
+    }
+
+    void update(const Key_ &_key, const Value_ &_value) {
+        updated_[_key] = _value;
+    }
+
+    void erase(const Key_ &_key) {
+        erased_.push_back(_key);
+    }
+
+    bool empty() const {
+        return (erased_.empty() && updated_.empty());
+    }
+
+    void apply(map_t &_value) const {
+        for (const auto &key : erased_)
+            _value.erase(key);
+        for (const auto &entry : updated_)
+            _value[entry.first] = entry.second;
+    }
+
+    template<class Derived_>
+    void write(OutputStream<Derived_> &_output) const {
+        _output << erased_ << updated_;
+    }
+
+    template<class Derived_>
+    void read(InputStream<Derived_> &_input) {
+        _input >> erased_ >> updated_;
+    }
+
+private:
+    std::vector<Key_> erased_;
+    map_t updated_;
+};
+
+template<int Index_, class Struct_>
+struct StructDeltaHelper {
+    static void compute(const Struct_ &_source, const Struct_ &_target, uint64_t &_changed) {
+        StructDeltaHelper<Index_-1, Struct_>::compute(_source, _target, _changed);
+        if (!(std::get<Index_>(_source.values_) == std::get<Index_>(_target.values_)))
+            _changed |= (uint64_t(1) << Index_);
+    }
+
+    static void apply(const Struct_ &_fields, uint64_t _changed, Struct_ &_value) {
+        StructDeltaHelper<Index_-1, Struct_>::apply(_fields, _changed, _value);
+        if (_changed & (uint64_t(1) << Index_))
+            std::get<Index_>(_value.values_) = std::get<Index_>(_fields.values_);
+    }
+
+    template<class Derived_>
+    static void write(OutputStream<Derived_> &_output, const Struct_ &_fields, uint64_t _changed) {
+        StructDeltaHelper<Index_-1, Struct_>::write(_output, _fields, _changed);
+        if (_changed & (uint64_t(1) << Index_))
+            _output << std::get<Index_>(_fields.values_);
+    }
+
+    template<class Derived_>
+    static void read(InputStream<Derived_> &_input, Struct_ &_fields, uint64_t _changed) {
+        StructDeltaHelper<Index_-1, Struct_>::read(_input, _fields, _changed);
+        if (_changed & (uint64_t(1) << Index_))
+            _input >> std::get<Index_>(_fields.values_);
+    }
+};
+
+template<class Struct_>
+struct StructDeltaHelper<-1, Struct_> {
+    static void compute(const Struct_ &, const Struct_ &, uint64_t &) {}
+    static void apply(const Struct_ &, uint64_t, Struct_ &) {}
+
+    template<class Derived_>
+    static void write(OutputStream<Derived_> &, const Struct_ &, uint64_t) {}
+
+    template<class Derived_>
+    static void read(InputStream<Derived_> &, Struct_ &, uint64_t) {}
+};
+
+/**
+ * \brief The changed fields of a struct. Only these are serialized,
+ *        preceded by a mask of their indices.
+ */
+template<class Struct_>
+class StructDelta {
+public:
+    static const int FIELDS = int(std::tuple_size<decltype(Struct_::values_)>::value);
+    static_assert(FIELDS <= 64, "StructDelta supports structs of up to 64 fields");
+
+    StructDelta()
+        : changed_(0) {
+    }
+
+    static StructDelta compute(const Struct_ &_source, const Struct_ &_target) {
+        StructDelta itsDelta;
+        StructDeltaHelper<FIELDS-1, Struct_>::compute(_source, _target, itsDelta.changed_);
+        itsDelta.fields_ = _target;
+        return itsDelta;
+    }
+
+    template<int Index_, typename Field_>
+    void update(const Field_ &_value) {
+        static_assert(Index_ >= 0 && Index_ < FIELDS, "Invalid field index");
+        std::get<Index_>(fields_.values_) = _value;
+        changed_ |= (uint64_t(1) << Index_);
+    }
+
+    bool isChanged(int _index) const {
+        return (0 != (changed_ & (uint64_t(1) << _index)));
+    }
+
+    bool empty() const {
+        return (0 == changed_);
+    }
+
+    void apply(Struct_ &_value) const {
+        StructDeltaHelper<FIELDS-1, Struct_>::apply(fields_, changed_, _value);
+    }
+
+    template<class Derived_>
+    void write(OutputStream<Derived_> &_output) const {
+        _output << changed_;
+        StructDeltaHelper<FIELDS-1, Struct_>::write(_output, fields_, changed_);
+    }
+
+    template<class Derived_>
+    void read(InputStream<Derived_> &_input) {
+        _input >> changed_;
+        StructDeltaHelper<FIELDS-1, Struct_>::read(_input, fields_, changed_);
+    }
+
+private:
+    uint64_t changed_;
+    Struct_ fields_;
+};
+
+template<class Derived_, typename Element_>
+OutputStream<Derived_> &operator<<(OutputStream<Derived_> &_output, const VectorDelta<Element_> &_value) {
+    _value.write(_output);
+    return _output;
+}
+
+template<class Derived_, typename Key_, typename Value_, typename Hasher_>
+OutputStream<Derived_> &operator<<(OutputStream<Derived_> &_output, const MapDelta<Key_, Value_, Hasher_> &_value) {
+    _value.write(_output);
+    return _output;
+}
+
+template<class Derived_, class Struct_>
+OutputStream<Derived_> &operator<<(OutputStream<Derived_> &_output, const StructDelta<Struct_> &_value) {
+    _value.write(_output);
+    return _output;
+}
+
+template<class Derived_, typename Element_>
+InputStream<Derived_> &operator>>(InputStream<Derived_> &_input, VectorDelta<Element_> &_value) {
+    _value.read(_input);
+    return _input;
+}
+
+template<class Derived_, typename Key_, typename Value_, typename Hasher_>
+InputStream<Derived_> &operator>>(InputStream<Derived_> &_input, MapDelta<Key_, Value_, Hasher_> &_value) {
+    _value.read(_input);
+    return _input;
+}
+
+template<class Derived_, class Struct_>
+InputStream<Derived_> &operator>>(InputStream<Derived_> &_input, StructDelta<Struct_> &_value) {
+    _value.read(_input);
+    return _input;
+}
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_DELTA_HPP_
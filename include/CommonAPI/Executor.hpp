@@ -0,0 +1,143 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_EXECUTOR_HPP_
+#define COMMONAPI_EXECUTOR_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <CommonAPI/ContainerUtils.hpp>
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/Types.hpp>
+
+namespace CommonAPI {
+
+class ThreadPool;
+
+/**
+ * \brief Executes the calls a binding receives for a stub.
+ *
+ * An executor is passed to Runtime::registerService. Bindings hand each
+ * incoming call to StubBase::execute, which forwards it to the executor of
+ * the stub, if one was set, and otherwise executes it directly on the
+ * dispatching thread as before.
+ */
+class Executor {
+public:
+    typedef std::function<void()> Task;
+
+    virtual ~Executor() {}
+
+    /**
+     * \brief Schedules a call.
+     *
+     * _client identifies the calling client and may be empty. _method is a
+     * binding specific identifier of the called method, for example its id
+     * or the hash of its name. Returns false if the call was rejected, the
+     * binding then replies with an error.
+     */
+    virtual bool execute(const std::shared_ptr<ClientId> &_client,
+                         std::size_t _method,
+                         Task _task) = 0;
+};
+
+/**
+ * \brief Executor running calls on a bounded pool of worker threads.
+ *
+ * The ordering policy determines which calls may run concurrently:
+ * - NONE: every call may run concurrently with every other call.
+ * - PER_CLIENT: calls of the same client are executed one after the other
+ *   in the order they were received. Calls without client are unordered.
+ * - PER_METHOD: calls of the same method are executed one after the other
+ *   in the order they were received.
+ *
+ * The number of received calls that have not yet started can be limited,
+ * further calls are rejected until the executor catches up. The executor
+ * waits for all accepted calls on destruction and therefore must not be
+ * destroyed by one of them.
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+    enum class Ordering {
+        NONE,
+        PER_CLIENT,
+        PER_METHOD
+    };
+
+    static const std::size_t UNLIMITED = 0;
+
+    /**
+     * \brief Creates an executor with its own pool of _threads workers.
+     */
+    COMMONAPI_EXPORT ThreadPoolExecutor(std::size_t _threads,
+                                        Ordering _ordering = Ordering::PER_CLIENT,
+                                        std::size_t _maxQueueSize = UNLIMITED);
+
+    /**
+     * \brief Creates an executor using a pool shared with others, for
+     *        example Runtime::getThreadPool().
+     */
+    COMMONAPI_EXPORT ThreadPoolExecutor(std::shared_ptr<ThreadPool> _pool,
+                                        Ordering _ordering = Ordering::PER_CLIENT,
+                                        std::size_t _maxQueueSize = UNLIMITED);
+
+    COMMONAPI_EXPORT virtual ~ThreadPoolExecutor();
+
+    ThreadPoolExecutor(const ThreadPoolExecutor &) = delete;
+    ThreadPoolExecutor &operator=(const ThreadPoolExecutor &) = delete;
+
+    COMMONAPI_EXPORT bool execute(const std::shared_ptr<ClientId> &_client,
+                                  std::size_t _method,
+                                  Task _task);
+
+    COMMONAPI_EXPORT Ordering getOrdering() const;
+    COMMONAPI_EXPORT std::size_t getMaxQueueSize() const;
+
+    /**
+     * \brief Returns the number of accepted calls that have not yet started.
+     */
+    COMMONAPI_EXPORT std::size_t getQueueSize() const;
+
+private:
+    // Calls that must be executed one after the other. A strand exists as
+    // long as one of its calls is scheduled or running.
+    struct Strand {
+        std::shared_ptr<ClientId> client_;
+        std::size_t method_;
+        std::deque<Task> tasks_;
+    };
+
+    void post(const std::shared_ptr<Strand> &_strand, Task _task);
+    void run(const std::shared_ptr<Strand> &_strand, const Task &_task);
+
+    std::shared_ptr<ThreadPool> pool_;
+    Ordering ordering_;
+    std::size_t maxQueueSize_;
+
+    std::unordered_map<std::shared_ptr<ClientId>, std::shared_ptr<Strand>,
+                       SharedPointerClientIdContentHash,
+                       SharedPointerClientIdContentEqual> clientStrands_;
+    std::unordered_map<std::size_t, std::shared_ptr<Strand>> methodStrands_;
+
+    std::size_t queued_;
+    std::size_t pending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable finished_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_EXECUTOR_HPP_
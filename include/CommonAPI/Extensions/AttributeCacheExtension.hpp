@@ -7,9 +7,16 @@
 #define COMMONAPI_EXTENSIONS_ATTRIBUTE_CACHE_EXTENSION_HPP_
 
 #include <CommonAPI/CommonAPI.hpp>
+#include <CommonAPI/Extensions/ContentHash.hpp>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <type_traits>
 
 namespace CommonAPI {
@@ -19,7 +26,7 @@ namespace AttributeCache {
 template<typename AttributeType_>
 struct AttributeTraits;
 
-template<typename AttributeType_, bool>
+template<typename AttributeType_, bool, bool = false>
 class AttributeCacheExtensionImpl;
 }
 
@@ -27,6 +34,15 @@ template <typename AttributeType_>
 using AttributeCacheExtension = AttributeCache::AttributeCacheExtensionImpl<AttributeType_,
                                                                             AttributeCache::AttributeTraits<AttributeType_>::observable>;
 
+// Caches small, trivially copyable values of observable attributes inline
+// instead of in a shared snapshot. Reading them with tryGetCachedValue does
+// not allocate, getCachedValue however allocates a copy on every call.
+// Other attributes get the same cache as with AttributeCacheExtension.
+template <typename AttributeType_>
+using InlineAttributeCacheExtension = AttributeCache::AttributeCacheExtensionImpl<AttributeType_,
+                                                                                  AttributeCache::AttributeTraits<AttributeType_>::observable,
+                                                                                  AttributeCache::AttributeTraits<AttributeType_>::inlineable>;
+
 namespace AttributeCache {
 
 template<typename AttributeType_>
@@ -39,8 +55,175 @@ struct AttributeTraits {
                                                     CommonAPI::ObservableReadonlyAttribute<
                                                             typename AttributeType_::ValueType>,
                                                     AttributeType_>::value);
+
+    // Small, trivially copyable values can be cached inline under a seqlock
+    static const std::size_t maximumInlineSize = 64;
+    static const bool inlineable = (observable
+                                    && std::is_trivially_copyable<typename AttributeType_::ValueType>::value
+                                    && sizeof(typename AttributeType_::ValueType) <= maximumInlineSize);
+};
+
+/**
+ * \brief Determines how an observable cache detects that a notified value
+ *        equals the cached one. Unchanged values only renew the time the
+ *        cached value was received, without allocating a new snapshot.
+ *
+ * - NONE: every notification replaces the cached value.
+ * - EQUALITY: values are compared with operator==.
+ * - HASH_ONLY: values with equal content hashes are taken as unchanged,
+ *   a hash collision however hides a change. Hashing a value is not
+ *   cheaper than comparing it with operator==: about as fast for large
+ *   arrays of floating point values, slower for other types.
+ *
+ * Values the content hash does not support are compared with operator==.
+ */
+enum class ChangeDetection {
+    NONE,
+    EQUALITY,
+    HASH_ONLY
+};
+
+// A cached value together with the time it was received
+template<typename Value_>
+struct CachedValue {
+    CachedValue(const Value_ &_value)
+        : value_(_value),
+          updated_(std::chrono::steady_clock::now().time_since_epoch().count()),
+          hash_(0),
+          isHashed_(false),
+          isStale_(false) {
+    }
+
+    CachedValue(const Value_ &_value, uint64_t _hash, bool _isHashed)
+        : value_(_value),
+          updated_(std::chrono::steady_clock::now().time_since_epoch().count()),
+          hash_(_hash),
+          isHashed_(_isHashed),
+          isStale_(false) {
+    }
+
+    // A stale value was restored from an attribute cache store and is not
+    // fresh until it was received again
+    bool isFresh(std::chrono::milliseconds _maxAge) const {
+        return (!isStale_
+                && std::chrono::steady_clock::now().time_since_epoch().count() - updated_.load(std::memory_order_relaxed)
+                   <= std::chrono::duration_cast<std::chrono::steady_clock::duration>(_maxAge).count());
+    }
+
+    void renew() const {
+        updated_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    bool isUnchanged(const Value_ &_value, uint64_t _hash, bool _isHashed,
+                     ChangeDetection _detection) const {
+        bool isHashComparable = (_isHashed && isHashed_);
+        switch (_detection) {
+        case ChangeDetection::NONE:
+            return false;
+        case ChangeDetection::HASH_ONLY:
+            if (isHashComparable)
+                return (_hash == hash_);
+            break;
+        default:
+            break;
+        }
+        return (value_ == _value);
+    }
+
+    Value_ value_;
+    mutable std::atomic<std::chrono::steady_clock::rep> updated_;
+    uint64_t hash_;
+    bool isHashed_;
+    bool isStale_;
+};
+
+// Keeps the cached value of an attribute under a key of a store. The store
+// takes the value from the source when it is saved, the source is detached
+// when the persistence is destroyed.
+class Persistence {
+public:
+    Persistence(std::shared_ptr<CommonAPI::AttributeCacheStore> _store, const std::string &_key)
+        : store_(_store), key_(_key), source_(0) {
+    }
+
+    ~Persistence() {
+        if (source_)
+            store_->detach(source_);
+    }
+
+    Persistence(const Persistence &) = delete;
+    Persistence &operator=(const Persistence &) = delete;
+
+    template<typename Value_>
+    bool restore(Value_ &_value) const {
+        CommonAPI::ByteBuffer itsBuffer;
+        if (!store_->get(key_, itsBuffer))
+            return false;
+
+        CommonAPI::MemoryInputStream itsStream(itsBuffer.data(), itsBuffer.size());
+        itsStream >> _value;
+        return (!itsStream.hasError() && 0 == itsStream.getRemaining());
+    }
+
+    void attach(CommonAPI::AttributeCacheStore::Source _source) {
+        if (source_)
+            store_->detach(source_);
+        source_ = store_->attach(key_, _source);
+    }
+
+    template<typename Value_>
+    static bool serialize(const Value_ &_value, CommonAPI::ByteBuffer &_buffer) {
+        CommonAPI::MemoryOutputStream itsStream(_buffer);
+        itsStream << _value;
+        return !itsStream.hasError();
+    }
+
+private:
+    std::shared_ptr<CommonAPI::AttributeCacheStore> store_;
+    std::string key_;
+    CommonAPI::AttributeCacheStore::SourceId source_;
+};
+
+// Periodically calls a function from a main loop. The function may destroy
+// the timeout, therefore dispatch does not access it afterwards.
+class RefreshTimeout : public CommonAPI::Timeout {
+public:
+    RefreshTimeout(int64_t _interval, std::function<void()> _refresh)
+        : interval_(_interval),
+          readyTime_(CommonAPI::getCurrentTimeInMs() + _interval),
+          refresh_(_refresh) {
+    }
+
+    bool dispatch() {
+        readyTime_ = CommonAPI::getCurrentTimeInMs() + interval_;
+        std::function<void()> itsRefresh(refresh_);
+        itsRefresh();
+        return true;
+    }
+
+    int64_t getTimeoutInterval() const {
+        return interval_;
+    }
+
+    int64_t getReadyTime() const {
+        return readyTime_;
+    }
+
+private:
+    int64_t interval_;
+    int64_t readyTime_;
+    std::function<void()> refresh_;
 };
 
+/*
+ * Non observable attributes are not notified about changes. Their value is
+ * cached when it is retrieved by refresh(), either on demand or periodically
+ * from a main loop. Readers never wait for the value to be retrieved.
+ *
+ * The main loop only knows the refresh timeout by its address. While the
+ * periodic refresh is started, the extension must therefore be destroyed
+ * on the thread that runs the main loop, or while it is not dispatching.
+ */
 template<typename AttributeType_>
 class AttributeCacheExtensionImpl<AttributeType_, false> : public CommonAPI::AttributeExtension<
         AttributeType_> {
@@ -48,12 +231,183 @@ protected:
     typedef CommonAPI::AttributeExtension<AttributeType_> __baseClass_t;
 
     typedef typename AttributeType_::ValueType value_t;
+    typedef std::shared_ptr<const value_t> valueptr_t;
+    typedef CachedValue<value_t> entry_t;
 
 public:
     AttributeCacheExtensionImpl(AttributeType_& baseAttribute)
-            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute) {
+            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute),
+              snapshot_(std::make_shared<Snapshot>()),
+              timeToLive_(0) {
+    }
+
+    ~AttributeCacheExtensionImpl() {
+        stopRefresh();
     }
 
+    /**
+     * @brief getCachedValue Retrieve attribute value from the cache
+     * @return The value of the attribute or a null pointer if the value is not
+     *         yet available or older than the time to live. With a time to
+     *         live, a stale value restored by enablePersistence is not
+     *         returned, use getLastKnownValue for it.
+     */
+    valueptr_t getCachedValue() {
+        int64_t timeToLive = timeToLive_.load(std::memory_order_relaxed);
+        if (timeToLive > 0)
+            return getCachedValueIfFresh(std::chrono::milliseconds(timeToLive));
+
+        return getLastKnownValue();
+    }
+
+    /**
+     * @brief getLastKnownValue Retrieve attribute value from the cache
+     *                          regardless of its age, including a stale
+     *                          value restored by enablePersistence.
+     * @return The value of the attribute or a null pointer if there is none.
+     */
+    valueptr_t getLastKnownValue() {
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&snapshot_->entry_);
+        return (entry ? valueptr_t(entry, &entry->value_) : nullptr);
+    }
+
+    /**
+     * @brief getCachedValue Retrieve attribute value from the cache returning a
+     *                       default value if the cache was empty.
+     * @param errorValue The value to return if the value could not be found in
+     *                   the cache.
+     * @return The value of the attribute or errorValue.
+     */
+    valueptr_t getCachedValue(const value_t &errorValue) {
+        valueptr_t result = getCachedValue();
+
+        if (!result)
+            result = std::make_shared<const value_t>(errorValue);
+
+        return result;
+    }
+
+    /**
+     * @brief getCachedValueIfFresh Retrieve attribute value from the cache if
+     *                              it was retrieved at most maxAge ago.
+     * @return The value of the attribute or a null pointer.
+     */
+    valueptr_t getCachedValueIfFresh(std::chrono::milliseconds maxAge) {
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&snapshot_->entry_);
+        return (entry && entry->isFresh(maxAge) ? valueptr_t(entry, &entry->value_) : nullptr);
+    }
+
+    /**
+     * @brief setTimeToLive Sets the age after which getCachedValue no longer
+     *                      returns a cached value. Zero disables expiry.
+     */
+    void setTimeToLive(std::chrono::milliseconds timeToLive) {
+        timeToLive_.store(timeToLive.count(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief refresh Retrieves the value asynchronously and caches it.
+     */
+    void refresh() {
+        std::weak_ptr<Snapshot> snapshot(snapshot_);
+        (void)__baseClass_t::getBaseAttribute().getValueAsyncLight(
+                [snapshot](const CommonAPI::CallStatus &callStatus, value_t t) {
+                    std::shared_ptr<Snapshot> itsSnapshot = snapshot.lock();
+                    if (itsSnapshot && callStatus == CommonAPI::CallStatus::SUCCESS) {
+                        std::atomic_store(&itsSnapshot->entry_,
+                                          std::shared_ptr<const entry_t>(std::make_shared<entry_t>(t)));
+                    }
+                });
+    }
+
+    /**
+     * @brief startRefresh Refreshes the value now and then every interval,
+     *                     using a timeout of the given main loop context.
+     *                     Must not be called concurrently with stopRefresh.
+     */
+    void startRefresh(std::shared_ptr<CommonAPI::MainLoopContext> context,
+                      std::chrono::milliseconds interval) {
+        stopRefresh();
+
+        context_ = context;
+        timeout_ = std::unique_ptr<RefreshTimeout>(
+                new RefreshTimeout(interval.count(), [this]() { refresh(); }));
+        context_->registerTimeoutSource(timeout_.get());
+        refresh();
+    }
+
+    /**
+     * @brief stopRefresh Stops the periodic refresh and frees its timeout.
+     *                    Must be called from the thread that runs the main
+     *                    loop, or while the main loop is not dispatching.
+     */
+    void stopRefresh() {
+        if (timeout_) {
+            context_->deregisterTimeoutSource(timeout_.get());
+            timeout_.reset();
+            context_.reset();
+        }
+    }
+
+    /**
+     * @brief enablePersistence Saves the cached value to store under key and
+     *                          seeds the cache with the value saved there by
+     *                          a previous run, unless a value was received
+     *                          already. The seeded value is stale: it is
+     *                          returned by getLastKnownValue, and by
+     *                          getCachedValue unless a time to live is set,
+     *                          but is not fresh until the value is refreshed.
+     */
+    void enablePersistence(std::shared_ptr<CommonAPI::AttributeCacheStore> store,
+                           const std::string &key) {
+        persistence_.reset();
+        persistence_ = std::unique_ptr<Persistence>(new Persistence(store, key));
+
+        value_t value;
+        if (persistence_->restore(value)) {
+            std::shared_ptr<entry_t> seeded = std::make_shared<entry_t>(value);
+            seeded->isStale_ = true;
+
+            std::shared_ptr<const entry_t> expected;
+            (void)std::atomic_compare_exchange_strong(&snapshot_->entry_, &expected,
+                                                      std::shared_ptr<const entry_t>(seeded));
+        }
+
+        std::shared_ptr<Snapshot> snapshot(snapshot_);
+        persistence_->attach([snapshot](CommonAPI::ByteBuffer &buffer) {
+            std::shared_ptr<const entry_t> entry = std::atomic_load(&snapshot->entry_);
+            return (entry && Persistence::serialize(entry->value_, buffer));
+        });
+    }
+
+    void disablePersistence() {
+        persistence_.reset();
+    }
+
+    /**
+     * @brief isCachedValueStale Returns true while the cached value is the
+     *                           one restored by enablePersistence.
+     */
+    bool isCachedValueStale() {
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&snapshot_->entry_);
+        return (entry && entry->isStale_);
+    }
+
+private:
+    // Shared with pending refreshes, that may finish after the extension
+    // was destroyed.
+    struct Snapshot {
+        std::shared_ptr<const entry_t> entry_;
+    };
+
+    std::shared_ptr<Snapshot> snapshot_;
+    std::atomic<int64_t> timeToLive_;
+
+    std::shared_ptr<CommonAPI::MainLoopContext> context_;
+    std::unique_ptr<RefreshTimeout> timeout_;
+
+    // Destroyed first, the source must not outlive the cache
+    std::unique_ptr<Persistence> persistence_;
 };
 
 template<typename AttributeType_>
@@ -67,7 +421,8 @@ protected:
 
 public:
     AttributeCacheExtensionImpl(AttributeType_& baseAttribute)
-            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute) {
+            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute),
+              changeDetection_(ChangeDetection::EQUALITY) {
         auto &event = __baseClass_t::getBaseAttribute().getChangedEvent();
         event.subscribe(
                 std::bind(
@@ -83,10 +438,190 @@ public:
      *         via the getChangedEvent.
      */
     valueptr_t getCachedValue() {
-        if (cachedValue_) {
-            return cachedValue_;
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&cachedEntry_);
+        return (entry ? valueptr_t(entry, &entry->value_) : nullptr);
+    }
+
+    /**
+     * @brief getCachedValue Retrieve attribute value from the cache returning a
+     *                       default value if the cache was empty.
+     * @param errorValue The value to return if the value could not be found in
+     *                   the cache.
+     * @return The value of the attribute or errorValue.
+     */
+    valueptr_t getCachedValue(const value_t &errorValue) {
+        valueptr_t result = getCachedValue();
+
+        if (!result)
+            result = std::make_shared<const value_t>(errorValue);
+
+        return result;
+    }
+
+    /**
+     * @brief getCachedValueIfFresh Retrieve attribute value from the cache if
+     *                              it was received at most maxAge ago.
+     * @return The value of the attribute or a null pointer.
+     */
+    valueptr_t getCachedValueIfFresh(std::chrono::milliseconds maxAge) {
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&cachedEntry_);
+        return (entry && entry->isFresh(maxAge) ? valueptr_t(entry, &entry->value_) : nullptr);
+    }
+
+    /**
+     * @brief setChangeDetection Sets how notified values are compared with
+     *                           the cached value, EQUALITY by default.
+     */
+    void setChangeDetection(ChangeDetection changeDetection) {
+        changeDetection_.store(changeDetection, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief enablePersistence Saves the cached value to store under key and
+     *                          seeds the cache with the value saved there by
+     *                          a previous run, unless a value was received
+     *                          already. The seeded value is stale: it is
+     *                          returned by getCachedValue, but is not fresh
+     *                          until the value is notified.
+     */
+    void enablePersistence(std::shared_ptr<CommonAPI::AttributeCacheStore> store,
+                           const std::string &key) {
+        persistence_.reset();
+        persistence_ = std::unique_ptr<Persistence>(new Persistence(store, key));
+
+        value_t value;
+        if (persistence_->restore(value)) {
+            std::shared_ptr<entry_t> seeded = std::make_shared<entry_t>(value);
+            seeded->isStale_ = true;
+
+            std::shared_ptr<const entry_t> expected;
+            (void)std::atomic_compare_exchange_strong(&cachedEntry_, &expected,
+                                                      std::shared_ptr<const entry_t>(seeded));
+        }
+
+        persistence_->attach([this](CommonAPI::ByteBuffer &buffer) {
+            std::shared_ptr<const entry_t> entry = std::atomic_load(&cachedEntry_);
+            return (entry && Persistence::serialize(entry->value_, buffer));
+        });
+    }
+
+    void disablePersistence() {
+        persistence_.reset();
+    }
+
+    /**
+     * @brief isCachedValueStale Returns true while the cached value is the
+     *                           one restored by enablePersistence.
+     */
+    bool isCachedValueStale() {
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&cachedEntry_);
+        return (entry && entry->isStale_);
+    }
+
+private:
+    typedef CachedValue<value_t> entry_t;
+
+    void valueRetrieved(const CommonAPI::CallStatus &callStatus, value_t t) {
+        if (callStatus == CommonAPI::CallStatus::SUCCESS) {
+            onValueUpdate(t);
+        }
+    }
+
+    // Readers may access the cached value from any thread while it is
+    // replaced, therefore it is published as an immutable snapshot that
+    // is swapped with std::atomic_store. Readers keep the snapshot they got
+    // alive. They never wait for a notification to be processed, but the
+    // atomic shared_ptr functions are not lock-free: libstdc++ briefly
+    // takes one of a small pool of mutexes selected by the address, which
+    // readers and the writer may contend for.
+    // The hash of a value is computed once, when it is notified, and kept
+    // with the snapshot for the comparison with the next value.
+    void onValueUpdate(const value_t& t) {
+        ChangeDetection detection = changeDetection_.load(std::memory_order_relaxed);
+
+        uint64_t hash(0);
+        bool isHashed(false);
+        if (detection == ChangeDetection::HASH_ONLY)
+            isHashed = getContentHash(t, hash);
+
+        // A stale entry is replaced even if unchanged, to confirm it
+        std::shared_ptr<const entry_t> entry = std::atomic_load(&cachedEntry_);
+        if (entry && !entry->isStale_ && entry->isUnchanged(t, hash, isHashed, detection)) {
+            entry->renew();
+            return;
         }
 
+        std::atomic_store(&cachedEntry_,
+                          std::shared_ptr<const entry_t>(std::make_shared<entry_t>(t, hash, isHashed)));
+    }
+
+    std::shared_ptr<const entry_t> cachedEntry_;
+    std::atomic<ChangeDetection> changeDetection_;
+
+    // Destroyed first, the source must not outlive the cache
+    std::unique_ptr<Persistence> persistence_;
+};
+
+template<typename AttributeType_>
+class AttributeCacheExtensionImpl<AttributeType_, true, true> : public CommonAPI::AttributeExtension<
+        AttributeType_> {
+    typedef CommonAPI::AttributeExtension<AttributeType_> __baseClass_t;
+
+protected:
+    typedef typename AttributeType_::ValueType value_t;
+    typedef std::shared_ptr<const value_t> valueptr_t;
+
+public:
+    AttributeCacheExtensionImpl(AttributeType_& baseAttribute)
+            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute),
+              sequence_(0) {
+        for (auto &word : words_)
+            word.store(0, std::memory_order_relaxed);
+
+        auto &event = __baseClass_t::getBaseAttribute().getChangedEvent();
+        event.subscribe(
+                std::bind(
+                        &AttributeCacheExtensionImpl<AttributeType_, true, true>::onValueUpdate,
+                        this, std::placeholders::_1));
+    }
+
+    /**
+     * @brief tryGetCachedValue Copy the attribute value from the cache
+     * @param value Filled with the cached value.
+     * @return false if the value is not yet available. Does neither
+     *         allocate nor modify shared state and therefore scales with
+     *         the number of reading threads.
+     */
+    bool tryGetCachedValue(value_t &value) const {
+        InlineEntry entry;
+        if (!read(entry))
+            return false;
+        value = entry.value_;
+        return true;
+    }
+
+    /**
+     * @brief tryGetCachedValueIfFresh Copy the attribute value from the cache
+     *                                 if it was received at most maxAge ago.
+     */
+    bool tryGetCachedValueIfFresh(value_t &value, std::chrono::milliseconds maxAge) const {
+        InlineEntry entry;
+        if (!read(entry) || !entry.isFresh(maxAge))
+            return false;
+        value = entry.value_;
+        return true;
+    }
+
+    /**
+     * @brief getCachedValue Retrieve attribute value from the cache
+     * @return The value of the attribute or a null pointer if the value is not
+     *         yet available. Allocates a copy of the value, prefer
+     *         tryGetCachedValue.
+     */
+    valueptr_t getCachedValue() {
+        value_t value;
+        if (tryGetCachedValue(value))
+            return std::make_shared<const value_t>(value);
         return nullptr;
     }
 
@@ -106,7 +641,96 @@ public:
         return result;
     }
 
+    /**
+     * @brief getCachedValueIfFresh Retrieve attribute value from the cache if
+     *                              it was received at most maxAge ago.
+     * @return The value of the attribute or a null pointer.
+     */
+    valueptr_t getCachedValueIfFresh(std::chrono::milliseconds maxAge) {
+        value_t value;
+        if (tryGetCachedValueIfFresh(value, maxAge))
+            return std::make_shared<const value_t>(value);
+        return nullptr;
+    }
+
+    /**
+     * @brief enablePersistence Saves the cached value to store under key and
+     *                          seeds the cache with the value saved there by
+     *                          a previous run, unless a value was received
+     *                          already. The seeded value is stale: it is
+     *                          returned by getCachedValue, but is not fresh
+     *                          until the value is notified.
+     */
+    void enablePersistence(std::shared_ptr<CommonAPI::AttributeCacheStore> store,
+                           const std::string &key) {
+        persistence_.reset();
+        persistence_ = std::unique_ptr<Persistence>(new Persistence(store, key));
+
+        InlineEntry entry;
+        if (persistence_->restore(entry.value_)) {
+            entry.updated_ = std::chrono::steady_clock::now().time_since_epoch().count();
+            entry.isStale_ = true;
+
+            std::lock_guard<std::mutex> itsLock(writeMutex_);
+            if (0 == sequence_.load(std::memory_order_relaxed))
+                write(entry);
+        }
+
+        persistence_->attach([this](CommonAPI::ByteBuffer &buffer) {
+            InlineEntry entry;
+            return (read(entry) && Persistence::serialize(entry.value_, buffer));
+        });
+    }
+
+    void disablePersistence() {
+        persistence_.reset();
+    }
+
+    /**
+     * @brief isCachedValueStale Returns true while the cached value is the
+     *                           one restored by enablePersistence.
+     */
+    bool isCachedValueStale() const {
+        InlineEntry entry;
+        return (read(entry) && entry.isStale_);
+    }
+
 private:
+    // The cached value, the time it was received and whether it was
+    // restored from a store
+    struct InlineEntry {
+        bool isFresh(std::chrono::milliseconds _maxAge) const {
+            return (!isStale_
+                    && std::chrono::steady_clock::now().time_since_epoch().count() - updated_
+                       <= std::chrono::duration_cast<std::chrono::steady_clock::duration>(_maxAge).count());
+        }
+
+        value_t value_;
+        std::chrono::steady_clock::rep updated_;
+        bool isStale_;
+    };
+
+    static const std::size_t WORDS
+        = (sizeof(InlineEntry) + sizeof(std::uintptr_t) - 1) / sizeof(std::uintptr_t);
+
+    bool read(InlineEntry &entry) const {
+        std::uintptr_t buffer[WORDS];
+        for (;;) {
+            std::uint32_t sequence = sequence_.load(std::memory_order_acquire);
+            if (0 == sequence)
+                return false;
+            if (sequence & 1)
+                continue;
+
+            for (std::size_t i = 0; i < WORDS; i++)
+                buffer[i] = words_[i].load(std::memory_order_acquire);
+
+            if (sequence == sequence_.load(std::memory_order_relaxed))
+                break;
+        }
+        std::memcpy(&entry, buffer, sizeof(InlineEntry));
+        return true;
+    }
 
     void valueRetrieved(const CommonAPI::CallStatus &callStatus, value_t t) {
         if (callStatus == CommonAPI::CallStatus::SUCCESS) {
@@ -114,15 +738,43 @@ private:
         }
     }
 
+    // The value is kept in atomic words to let readers copy it while it is
+    // written. An odd sequence marks a write in progress, readers retry if
+    // the sequence changed while they copied. A reader that sees a word of
+    // a write (release/acquire) also sees the sequence of that write.
     void onValueUpdate(const value_t& t) {
-        if (cachedValue_ && *cachedValue_ == t) {
-            return;
-        }
+        InlineEntry entry;
+        entry.value_ = t;
+        entry.updated_ = std::chrono::steady_clock::now().time_since_epoch().count();
+        entry.isStale_ = false;
 
-        cachedValue_ = std::make_shared<const value_t>(t);
+        std::lock_guard<std::mutex> itsLock(writeMutex_);
+        write(entry);
     }
 
-    valueptr_t cachedValue_;
+    // Must be called with the write mutex locked
+    void write(const InlineEntry &entry) {
+        std::uintptr_t buffer[WORDS] = {};
+        std::memcpy(buffer, &entry, sizeof(InlineEntry));
+
+        // Zero is reserved for "no value"
+        std::uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        std::uint32_t next = sequence + 2;
+        if (0 == next)
+            next = 2;
+
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < WORDS; i++)
+            words_[i].store(buffer[i], std::memory_order_release);
+        sequence_.store(next, std::memory_order_release);
+    }
+
+    std::atomic<std::uint32_t> sequence_;
+    std::atomic<std::uintptr_t> words_[WORDS];
+    std::mutex writeMutex_;
+
+    // Destroyed first, the source must not outlive the cache
+    std::unique_ptr<Persistence> persistence_;
 };
 
 } // namespace AttributeCache
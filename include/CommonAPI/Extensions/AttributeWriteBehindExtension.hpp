@@ -0,0 +1,147 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef COMMONAPI_EXTENSIONS_ATTRIBUTE_WRITE_BEHIND_EXTENSION_HPP_
+#define COMMONAPI_EXTENSIONS_ATTRIBUTE_WRITE_BEHIND_EXTENSION_HPP_
+
+#include <CommonAPI/CommonAPI.hpp>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace CommonAPI {
+namespace Extensions {
+
+/*
+ * Writes the value of an attribute behind the caller. At most one request
+ * is in flight, values set meanwhile replace each other and only the newest
+ * is written once the request completed. The callbacks of replaced values
+ * complete together with the request that wrote the newest value, with its
+ * status and response. Callbacks are called without any lock held, from
+ * the thread completing the request.
+ */
+template<typename AttributeType_>
+class AttributeWriteBehindExtension : public CommonAPI::AttributeExtension<AttributeType_> {
+    typedef CommonAPI::AttributeExtension<AttributeType_> __baseClass_t;
+
+protected:
+    typedef typename AttributeType_::ValueType value_t;
+    typedef typename AttributeType_::AttributeAsyncCallback callback_t;
+
+public:
+    AttributeWriteBehindExtension(AttributeType_& baseAttribute)
+            : CommonAPI::AttributeExtension<AttributeType_>(baseAttribute),
+              state_(std::make_shared<State>(baseAttribute)) {
+    }
+
+    /**
+     * @brief setValueAsync Writes the value, or replaces the value waiting
+     *                      to be written if a request is in flight.
+     * @return A future fulfilled with the status of the request that wrote
+     *         this value or a newer one. If the extension is destroyed
+     *         before such a request was sent, the callback is not called
+     *         and the future receives CallStatus::UNKNOWN.
+     */
+    CommonAPI::Future<CommonAPI::CallStatus> setValueAsync(const value_t &value,
+                                                           callback_t callback = nullptr) {
+        Waiter waiter(callback);
+        CommonAPI::Future<CommonAPI::CallStatus> future = waiter.promise_.getFuture();
+
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> itsLock(state_->mutex_);
+            if (state_->isWriting_) {
+                state_->value_ = value;
+                state_->hasValue_ = true;
+                state_->waiters_.push_back(std::move(waiter));
+                return future;
+            }
+            state_->isWriting_ = true;
+            waiters.push_back(std::move(waiter));
+        }
+
+        write(state_, value, std::move(waiters));
+        return future;
+    }
+
+    /**
+     * @brief isWriting Returns true while a request is in flight.
+     */
+    bool isWriting() const {
+        std::lock_guard<std::mutex> itsLock(state_->mutex_);
+        return state_->isWriting_;
+    }
+
+private:
+    struct Waiter {
+        Waiter(callback_t _callback)
+            : callback_(_callback) {
+        }
+
+        callback_t callback_;
+        CommonAPI::Promise<CommonAPI::CallStatus> promise_;
+    };
+
+    // Shared with the request in flight, that may complete after the
+    // extension was destroyed
+    struct State {
+        State(CommonAPI::Attribute<value_t> &_attribute)
+            : attribute_(_attribute), isWriting_(false), hasValue_(false) {
+        }
+
+        CommonAPI::Attribute<value_t> &attribute_;
+
+        std::mutex mutex_;
+        bool isWriting_;
+        bool hasValue_;
+        value_t value_;
+        std::vector<Waiter> waiters_;
+    };
+
+    static void write(const std::shared_ptr<State> &state, const value_t &value,
+                      std::vector<Waiter> waiters) {
+        std::shared_ptr<std::vector<Waiter>> requestWaiters
+            = std::make_shared<std::vector<Waiter>>(std::move(waiters));
+        std::weak_ptr<State> weakState(state);
+        (void)state->attribute_.setValueAsyncLight(
+                value,
+                [weakState, requestWaiters](const CommonAPI::CallStatus &callStatus, value_t response) {
+                    for (auto &waiter : *requestWaiters) {
+                        if (waiter.callback_)
+                            waiter.callback_(callStatus, response);
+                        waiter.promise_.setValue(callStatus);
+                    }
+
+                    std::shared_ptr<State> itsState = weakState.lock();
+                    if (itsState)
+                        writeNext(itsState);
+                });
+    }
+
+    static void writeNext(const std::shared_ptr<State> &state) {
+        value_t value;
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> itsLock(state->mutex_);
+            if (!state->hasValue_) {
+                state->isWriting_ = false;
+                return;
+            }
+            value = std::move(state->value_);
+            state->hasValue_ = false;
+            waiters.swap(state->waiters_);
+        }
+        write(state, value, std::move(waiters));
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace Extensions
+} // namespace CommonAPI
+
+#endif // COMMONAPI_EXTENSIONS_ATTRIBUTE_WRITE_BEHIND_EXTENSION_HPP_
@@ -0,0 +1,258 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef COMMONAPI_EXTENSIONS_CONTENT_HASH_HPP_
+#define COMMONAPI_EXTENSIONS_CONTENT_HASH_HPP_
+
+#include <CommonAPI/CommonAPI.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace CommonAPI {
+namespace Extensions {
+
+/**
+ * \brief Computes a 64 bit hash over the content of a value.
+ *
+ * The hash is meant to detect changes of large values, it is not
+ * stable across processes or versions. Contiguous arrays of arithmetic
+ * values are hashed as a whole. Values of types the hasher does not know
+ * mark the hash as incomplete, it must then not be used.
+ */
+class ContentHasher {
+public:
+    ContentHasher()
+        : hash_(SEED), isComplete_(true) {
+    }
+
+    void add(uint64_t _value) {
+        hash_ = mix(hash_ ^ _value);
+    }
+
+    // Bytes are consumed in blocks of 64 by eight independent lanes, which
+    // lets the compiler interleave or vectorize the multiplications.
+    void addBytes(const void *_data, std::size_t _size) {
+        const unsigned char *itsData = static_cast<const unsigned char *>(_data);
+        uint64_t itsLanes[LANES];
+        for (std::size_t l = 0; l < LANES; l++)
+            itsLanes[l] = hash_ + l * PRIME;
+
+        std::size_t itsPosition(0);
+        for (; itsPosition + LANES * sizeof(uint64_t) <= _size; itsPosition += LANES * sizeof(uint64_t)) {
+            for (std::size_t l = 0; l < LANES; l++) {
+                uint64_t itsWord;
+                std::memcpy(&itsWord, itsData + itsPosition + l * sizeof(uint64_t), sizeof(uint64_t));
+                itsLanes[l] = (itsLanes[l] ^ itsWord) * PRIME;
+                itsLanes[l] ^= (itsLanes[l] >> 29);
+            }
+        }
+
+        // An empty vector or string may pass a null pointer
+        uint64_t itsTail[LANES] = {};
+        if (itsPosition < _size)
+            std::memcpy(itsTail, itsData + itsPosition, _size - itsPosition);
+        for (std::size_t l = 0; l < LANES; l++)
+            itsLanes[l] = (itsLanes[l] ^ itsTail[l]) * PRIME;
+
+        uint64_t itsHash(_size);
+        for (std::size_t l = 0; l < LANES; l++)
+            itsHash = mix(itsHash ^ itsLanes[l]);
+        hash_ = itsHash;
+    }
+
+    uint64_t getHash() const {
+        return hash_;
+    }
+
+    bool isComplete() const {
+        return isComplete_;
+    }
+
+    void setIncomplete() {
+        isComplete_ = false;
+    }
+
+private:
+    static const std::size_t LANES = 8;
+    static const uint64_t SEED = 0x9e3779b97f4a7c15ULL;
+    static const uint64_t PRIME = 0x9fb21c651e98df25ULL;
+
+    static uint64_t mix(uint64_t _value) {
+        _value = (_value ^ (_value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        _value = (_value ^ (_value >> 27)) * 0x94d049bb133111ebULL;
+        return (_value ^ (_value >> 31));
+    }
+
+    uint64_t hash_;
+    bool isComplete_;
+};
+
+namespace ContentHash {
+
+// Lowest ranked match for all types without a hashValue overload
+struct AnyValue {
+    template<typename Type_>
+    AnyValue(const Type_ &) {}
+};
+
+inline void hashValue(ContentHasher &_hasher, const AnyValue &);
+
+template<typename Type_>
+typename std::enable_if<std::is_arithmetic<Type_>::value || std::is_enum<Type_>::value>::type
+hashValue(ContentHasher &_hasher, const Type_ &_value);
+
+inline void hashValue(ContentHasher &_hasher, const std::string &_value);
+
+template<typename Base_>
+void hashValue(ContentHasher &_hasher, const Enumeration<Base_> &_value);
+
+template<typename Type_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::vector<Type_, Allocator_> &_value);
+
+template<typename Key_, typename Value_, typename Compare_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::map<Key_, Value_, Compare_, Allocator_> &_value);
+
+template<typename Key_, typename Value_, typename Hash_, typename Equal_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::unordered_map<Key_, Value_, Hash_, Equal_, Allocator_> &_value);
+
+template<typename... Types_>
+void hashValue(ContentHasher &_hasher, const Struct<Types_...> &_value);
+
+template<typename... Types_>
+void hashValue(ContentHasher &_hasher, const Variant<Types_...> &_value);
+
+template<int Index_, class Struct_>
+struct StructHasher {
+    void operator()(ContentHasher &_hasher, const Struct_ &_struct) {
+        StructHasher<Index_-1, Struct_>{}(_hasher, _struct);
+        hashValue(_hasher, std::get<Index_>(_struct.values_));
+    }
+};
+
+template<class Struct_>
+struct StructHasher<-1, Struct_> {
+    void operator()(ContentHasher &, const Struct_ &) {
+    }
+};
+
+struct VariantHasher {
+    VariantHasher(ContentHasher &_hasher)
+        : hasher_(_hasher) {
+    }
+
+    template<typename Type_>
+    void operator()(const Type_ &_value) {
+        hashValue(hasher_, _value);
+    }
+
+    ContentHasher &hasher_;
+};
+
+template<typename Type_, typename Allocator_>
+void hashElements(ContentHasher &_hasher, const std::vector<Type_, Allocator_> &_value, std::true_type) {
+    _hasher.addBytes(_value.data(), _value.size() * sizeof(Type_));
+}
+
+template<typename Type_, typename Allocator_>
+void hashElements(ContentHasher &_hasher, const std::vector<Type_, Allocator_> &_value, std::false_type) {
+    for (const auto &element : _value)
+        hashValue(_hasher, element);
+}
+
+inline void hashValue(ContentHasher &_hasher, const AnyValue &) {
+    _hasher.setIncomplete();
+}
+
+template<typename Type_>
+typename std::enable_if<std::is_arithmetic<Type_>::value || std::is_enum<Type_>::value>::type
+hashValue(ContentHasher &_hasher, const Type_ &_value) {
+    uint64_t itsValue(0);
+    std::memcpy(&itsValue, &_value, sizeof(Type_) < sizeof(itsValue) ? sizeof(Type_) : sizeof(itsValue));
+    _hasher.add(itsValue);
+}
+
+inline void hashValue(ContentHasher &_hasher, const std::string &_value) {
+    _hasher.addBytes(_value.data(), _value.size());
+}
+
+template<typename Base_>
+void hashValue(ContentHasher &_hasher, const Enumeration<Base_> &_value) {
+    hashValue(_hasher, _value.value_);
+}
+
+template<typename Type_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::vector<Type_, Allocator_> &_value) {
+    _hasher.add(_value.size());
+    hashElements(_hasher, _value,
+                 std::integral_constant<bool,
+                     (std::is_arithmetic<Type_>::value || std::is_enum<Type_>::value)
+                     && sizeof(Type_) <= sizeof(uint64_t)
+                     && !std::is_same<Type_, bool>::value>());
+}
+
+template<typename Key_, typename Value_, typename Compare_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::map<Key_, Value_, Compare_, Allocator_> &_value) {
+    _hasher.add(_value.size());
+    for (const auto &element : _value) {
+        hashValue(_hasher, element.first);
+        hashValue(_hasher, element.second);
+    }
+}
+
+// Equal unordered maps may iterate in different orders, therefore the
+// hashes of the elements are combined commutatively
+template<typename Key_, typename Value_, typename Hash_, typename Equal_, typename Allocator_>
+void hashValue(ContentHasher &_hasher, const std::unordered_map<Key_, Value_, Hash_, Equal_, Allocator_> &_value) {
+    uint64_t itsSum(0);
+    for (const auto &element : _value) {
+        ContentHasher itsHasher;
+        hashValue(itsHasher, element.first);
+        hashValue(itsHasher, element.second);
+        if (!itsHasher.isComplete())
+            _hasher.setIncomplete();
+        itsSum += itsHasher.getHash();
+    }
+    _hasher.add(_value.size());
+    _hasher.add(itsSum);
+}
+
+template<typename... Types_>
+void hashValue(ContentHasher &_hasher, const Struct<Types_...> &_value) {
+    StructHasher<int(sizeof...(Types_)) - 1, Struct<Types_...>>{}(_hasher, _value);
+}
+
+template<typename... Types_>
+void hashValue(ContentHasher &_hasher, const Variant<Types_...> &_value) {
+    _hasher.add(_value.getValueType());
+    if (_value.hasValue() && _value.getValueType() > 0) {
+        VariantHasher itsVisitor(_hasher);
+        ApplyVoidVisitor<VariantHasher, Variant<Types_...>, Types_...>::visit(itsVisitor, _value);
+    }
+}
+
+} // namespace ContentHash
+
+/**
+ * \brief Computes the content hash of a value. Returns false if the value
+ *        contains types that cannot be hashed.
+ */
+template<typename Value_>
+bool getContentHash(const Value_ &_value, uint64_t &_hash) {
+    ContentHasher itsHasher;
+    ContentHash::hashValue(itsHasher, _value);
+    _hash = itsHasher.getHash();
+    return itsHasher.isComplete();
+}
+
+} // namespace Extensions
+} // namespace CommonAPI
+
+#endif // COMMONAPI_EXTENSIONS_CONTENT_HASH_HPP_
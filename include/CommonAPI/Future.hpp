@@ -0,0 +1,362 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_FUTURE_HPP_
+#define COMMONAPI_FUTURE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <CommonAPI/Types.hpp>
+
+namespace CommonAPI {
+
+template<typename Value_>
+class Future;
+
+template<typename Value_>
+class Promise;
+
+/**
+ * \brief Value a future receives if its promise is destroyed unfulfilled.
+ */
+template<typename Value_>
+struct BrokenPromiseValue {
+    static Value_ get() { return Value_(); }
+};
+
+template<>
+struct BrokenPromiseValue<CallStatus> {
+    static CallStatus get() { return CallStatus::UNKNOWN; }
+};
+
+/**
+ * \brief Shared state of a Future/Promise pair.
+ *
+ * The value is stored inline and handed over by a single atomic operation.
+ * A thread blocking on the value parks on a mutex and condition variable
+ * that is created on first use, continuations and polling never need
+ * them. A binding may derive its
+ * per-call object from FutureState and override destroy() to let the call
+ * object own the state, so that no allocation besides the call object itself
+ * is needed.
+ */
+template<typename Value_>
+class FutureState {
+public:
+    typedef std::function<void(const Value_ &)> Continuation;
+
+    FutureState()
+        : references_(0), promises_(0), flags_(0), parking_(nullptr) {
+    }
+
+    virtual ~FutureState() {
+        if (flags_.load(std::memory_order_acquire) & HAS_VALUE) {
+            getValue().~Value_();
+        }
+        delete parking_.load(std::memory_order_relaxed);
+    }
+
+    FutureState(const FutureState &) = delete;
+    FutureState &operator=(const FutureState &) = delete;
+
+protected:
+    /**
+     * Called once the last Future or Promise let go of this state.
+     */
+    virtual void destroy() {
+        delete this;
+    }
+
+private:
+    struct Parking {
+        std::mutex mutex_;
+        std::condition_variable condition_;
+    };
+
+    enum : uint8_t {
+        HAS_VALUE = 0x1,
+        HAS_CONTINUATION = 0x2,
+        IS_CLAIMED = 0x4
+    };
+
+    void acquire(bool _isPromise) {
+        references_.fetch_add(1, std::memory_order_relaxed);
+        if (_isPromise)
+            promises_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release(bool _isPromise) {
+        if (_isPromise
+                && promises_.fetch_sub(1, std::memory_order_acq_rel) == 1
+                && !isReady()) {
+            setValue(BrokenPromiseValue<Value_>::get());
+        }
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy();
+        }
+    }
+
+    bool isReady() const {
+        return (0 != (flags_.load(std::memory_order_acquire) & HAS_VALUE));
+    }
+
+    template<typename Argument_>
+    bool setValue(Argument_ &&_value) {
+        // Claim the storage first, concurrent setters lose here
+        if (flags_.fetch_or(IS_CLAIMED, std::memory_order_acquire) & IS_CLAIMED)
+            return false;
+
+        new (&storage_) Value_(std::forward<Argument_>(_value));
+        uint8_t previous = flags_.fetch_or(HAS_VALUE, std::memory_order_seq_cst);
+
+        // Either a parked waiter is seen here, or it sees the value before
+        // it waits (both sides use sequentially consistent operations)
+        Parking *itsParking = parking_.load(std::memory_order_seq_cst);
+        if (itsParking) {
+            std::lock_guard<std::mutex> itsLock(itsParking->mutex_);
+            itsParking->condition_.notify_all();
+        }
+
+        if (previous & HAS_CONTINUATION) {
+            continuation_(getValue());
+            continuation_ = nullptr;
+        }
+        return true;
+    }
+
+    void setContinuation(Continuation _continuation) {
+        continuation_ = std::move(_continuation);
+        uint8_t previous = flags_.fetch_or(HAS_CONTINUATION, std::memory_order_acq_rel);
+        if (previous & HAS_VALUE) {
+            continuation_(getValue());
+            continuation_ = nullptr;
+        }
+    }
+
+    const Value_ &getValue() const {
+        return *reinterpret_cast<const Value_ *>(&storage_);
+    }
+
+    bool waitUntil(const std::chrono::steady_clock::time_point *_deadline) const {
+        static const unsigned int YIELD_ROUNDS(16);
+
+        // Short waits are common for local calls and are served by yielding
+        for (unsigned int round = 0; round < YIELD_ROUNDS; round++) {
+            if (isReady())
+                return true;
+            std::this_thread::yield();
+        }
+
+        Parking *itsParking = getParking();
+        std::unique_lock<std::mutex> itsLock(itsParking->mutex_);
+        while (!(flags_.load(std::memory_order_seq_cst) & HAS_VALUE)) {
+            if (!_deadline) {
+                itsParking->condition_.wait(itsLock);
+            } else if (itsParking->condition_.wait_until(itsLock, *_deadline) == std::cv_status::timeout) {
+                return isReady();
+            }
+        }
+        return true;
+    }
+
+    Parking *getParking() const {
+        Parking *itsParking = parking_.load(std::memory_order_seq_cst);
+        if (!itsParking) {
+            Parking *itsNew = new Parking();
+            if (parking_.compare_exchange_strong(itsParking, itsNew, std::memory_order_seq_cst)) {
+                itsParking = itsNew;
+            } else {
+                delete itsNew;
+            }
+        }
+        return itsParking;
+    }
+
+    std::atomic<uint32_t> references_;
+    std::atomic<uint32_t> promises_;
+    std::atomic<uint8_t> flags_;
+    mutable std::atomic<Parking *> parking_;
+
+    typename std::aligned_storage<sizeof(Value_), std::alignment_of<Value_>::value>::type storage_;
+    Continuation continuation_;
+
+friend class Future<Value_>;
+friend class Promise<Value_>;
+};
+
+/**
+ * \brief Lightweight counterpart of std::future. Fulfilling the promise and
+ *        attaching a continuation take no lock, only blocking waiters park
+ *        on a mutex.
+ *
+ * A Future is obtained from a Promise. It can be waited on like a
+ * std::future, or a continuation can be attached using then(), which is
+ * called exactly once either by the thread fulfilling the promise or, if
+ * the value is already available, directly from then().
+ */
+template<typename Value_>
+class Future {
+public:
+    Future() : state_(nullptr) {}
+
+    Future(Future &&_other) : state_(_other.state_) {
+        _other.state_ = nullptr;
+    }
+
+    Future &operator=(Future &&_other) {
+        if (this != &_other) {
+            reset();
+            state_ = _other.state_;
+            _other.state_ = nullptr;
+        }
+        return (*this);
+    }
+
+    Future(const Future &) = delete;
+    Future &operator=(const Future &) = delete;
+
+    ~Future() {
+        reset();
+    }
+
+    bool valid() const {
+        return (nullptr != state_);
+    }
+
+    bool isReady() const {
+        return (state_ && state_->isReady());
+    }
+
+    void wait() const {
+        if (state_)
+            (void)state_->waitUntil(nullptr);
+    }
+
+    template<class Rep_, class Period_>
+    std::future_status wait_for(const std::chrono::duration<Rep_, Period_> &_duration) const {
+        std::chrono::steady_clock::time_point deadline
+            = std::chrono::steady_clock::now()
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_duration);
+        if (state_ && state_->waitUntil(&deadline))
+            return std::future_status::ready;
+        return std::future_status::timeout;
+    }
+
+    /**
+     * \brief Blocks until the value is available and returns it.
+     */
+    Value_ get() const {
+        wait();
+        return (state_ ? state_->getValue() : BrokenPromiseValue<Value_>::get());
+    }
+
+    /**
+     * \brief Attaches a continuation to this future.
+     *
+     * Only one continuation can be attached. The continuation might be called
+     * from the thread that fulfills the promise and therefore should not block.
+     */
+    void then(typename FutureState<Value_>::Continuation _continuation) {
+        if (state_)
+            state_->setContinuation(std::move(_continuation));
+    }
+
+private:
+    explicit Future(FutureState<Value_> *_state) : state_(_state) {
+        state_->acquire(false);
+    }
+
+    void reset() {
+        if (state_) {
+            state_->release(false);
+            state_ = nullptr;
+        }
+    }
+
+    FutureState<Value_> *state_;
+
+friend class Promise<Value_>;
+};
+
+/**
+ * \brief Producer side of a CommonAPI::Future.
+ *
+ * Promises are copyable to allow capturing them in std::function objects.
+ * All copies share the same state, the first value set wins. If the last
+ * copy is destroyed without a value being set, the future receives the
+ * value given by BrokenPromiseValue.
+ */
+template<typename Value_>
+class Promise {
+public:
+    Promise() : state_(new FutureState<Value_>()) {
+        state_->acquire(true);
+    }
+
+    /**
+     * \brief Creates a promise on a state that is owned by the caller.
+     */
+    explicit Promise(FutureState<Value_> *_state) : state_(_state) {
+        state_->acquire(true);
+    }
+
+    Promise(const Promise &_other) : state_(_other.state_) {
+        if (state_)
+            state_->acquire(true);
+    }
+
+    Promise(Promise &&_other) : state_(_other.state_) {
+        _other.state_ = nullptr;
+    }
+
+    Promise &operator=(Promise _other) {
+        std::swap(state_, _other.state_);
+        return (*this);
+    }
+
+    ~Promise() {
+        if (state_)
+            state_->release(true);
+    }
+
+    /**
+     * \brief Returns the future of this promise, or an invalid future if
+     *        the promise was moved from.
+     */
+    Future<Value_> getFuture() {
+        if (!state_)
+            return Future<Value_>();
+        return Future<Value_>(state_);
+    }
+
+    bool setValue(const Value_ &_value) {
+        return (state_ && state_->setValue(_value));
+    }
+
+    bool setValue(Value_ &&_value) {
+        return (state_ && state_->setValue(std::move(_value)));
+    }
+
+private:
+    FutureState<Value_> *state_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_FUTURE_HPP_
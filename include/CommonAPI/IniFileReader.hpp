@@ -6,33 +6,101 @@
 #ifndef COMMONAPI_INIFILEREADER_HPP_
 #define COMMONAPI_INIFILEREADER_HPP_
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <CommonAPI/Export.hpp>
+#include <CommonAPI/StringView.hpp>
 
 namespace CommonAPI {
 
+/**
+ * \brief Reader for ini files.
+ *
+ * load() copies all sections, keys and values into maps of strings, which
+ * are accessed by getSections() and getSection(). scan() instead reads the
+ * file into a single buffer and scans it once, keeping only views of the
+ * buffer in two flat, sorted arrays. The view accessors hasSection(),
+ * getValueView(), getSectionNames() and forEach() work with both modes.
+ * Views are valid as long as the reader exists and is not loaded again.
+ * A copy of a scanned reader has its own buffer and views.
+ */
 class IniFileReader {
 public:
+    typedef std::function<void(const StringView &, const StringView &)> MappingHandler;
+
     class Section {
     public:
         COMMONAPI_EXPORT const std::map<std::string, std::string> &getMappings() const;
         COMMONAPI_EXPORT std::string getValue(const std::string &_key) const;
+        COMMONAPI_EXPORT StringView getValueView(const StringView &_key) const;
     private:
         std::map<std::string, std::string> mappings_;
 
     friend class IniFileReader;
     };
 
+    /**
+     * \brief Size and modification time of a file, as it was read.
+     */
+    struct FileStatus {
+        FileStatus() : isValid_(false), size_(0), seconds_(0), nanoseconds_(0) {}
+
+        bool isValid_;
+        uint64_t size_;
+        int64_t seconds_;
+        int64_t nanoseconds_;
+    };
+
+    COMMONAPI_EXPORT IniFileReader();
+    COMMONAPI_EXPORT IniFileReader(const IniFileReader &_other);
+    COMMONAPI_EXPORT ~IniFileReader();
+
+    COMMONAPI_EXPORT IniFileReader &operator=(const IniFileReader &_other);
+
     COMMONAPI_EXPORT bool load(const std::string &_path);
 
+    /**
+     * \brief Reads and scans the file. getSections() and getSection() are
+     *        not available in this mode. As with load(), a file that does
+     *        not exist results in an empty configuration.
+     */
+    COMMONAPI_EXPORT bool scan(const std::string &_path);
+
+    /**
+     * \brief Like scan(), and stores the status of the file in _status. It is
+     *        taken from the descriptor the file is read from, before reading.
+     *        _status stays invalid if the file does not exist or changed
+     *        while it was read.
+     */
+    COMMONAPI_EXPORT bool scan(const std::string &_path, FileStatus &_status);
+
     COMMONAPI_EXPORT const std::map<std::string, std::shared_ptr<Section>> &getSections() const;
     COMMONAPI_EXPORT std::shared_ptr<Section> getSection(const std::string &_name) const;
 
+    COMMONAPI_EXPORT bool hasSection(const StringView &_section) const;
+    COMMONAPI_EXPORT StringView getValueView(const StringView &_section, const StringView &_key) const;
+    COMMONAPI_EXPORT std::vector<StringView> getSectionNames() const;
+
+    /**
+     * \brief Calls _handler with key and value of all keys of a section,
+     *        sorted by key.
+     */
+    COMMONAPI_EXPORT void forEach(const StringView &_section, const MappingHandler &_handler) const;
+
 private:
+    // Buffer and views of a scanned file
+    struct Scan;
+
+    void reset();
+
     std::map<std::string, std::shared_ptr<Section>> sections_;
+    std::unique_ptr<Scan> scan_;
 };
 
 } // namespace CommonAPI
@@ -0,0 +1,162 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_LOCALFACTORY_HPP_
+#define COMMONAPI_LOCALFACTORY_HPP_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <CommonAPI/Address.hpp>
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/Factory.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Serializes the calls to a locally connected stub or proxy.
+ *
+ * Tasks are executed one after the other in the order they were posted.
+ * If a MainLoopContext is given, they are executed by a DispatchSource
+ * registered with that context when the first task is posted, otherwise by
+ * the runtime's thread pool. The dispatcher must be owned by a shared_ptr.
+ */
+class LocalDispatcher
+        : public std::enable_shared_from_this<LocalDispatcher> {
+public:
+    typedef std::function<void()> Task;
+
+    COMMONAPI_EXPORT LocalDispatcher(std::shared_ptr<MainLoopContext> _context);
+    COMMONAPI_EXPORT ~LocalDispatcher();
+
+    LocalDispatcher(const LocalDispatcher &) = delete;
+    LocalDispatcher &operator=(const LocalDispatcher &) = delete;
+
+    COMMONAPI_EXPORT void post(Task _task);
+
+    COMMONAPI_EXPORT const std::shared_ptr<MainLoopContext> &getContext() const;
+
+private:
+    struct Source;
+
+    void schedule();
+    bool hasTasks();
+    bool runTasks();
+
+    std::shared_ptr<MainLoopContext> context_;
+    std::unique_ptr<Source> source_;
+    std::once_flag isRegistered_;
+
+    std::deque<Task> tasks_;
+    bool isScheduled_;
+    std::mutex mutex_;
+};
+
+/**
+ * \brief Binding connecting proxies directly to stubs of the same process.
+ *
+ * The factory is activated by registering it for LOCAL_BINDING:
+ *
+ *     Runtime::get()->registerFactory(LOCAL_BINDING, LocalFactory::get());
+ *
+ * Afterwards, every stub registered by Runtime::registerService is also
+ * known to the local factory, and Runtime::buildProxy returns a local proxy
+ * for it, whatever connection is used. The local registration only comes
+ * in addition to a successful registration with a binding, unless
+ * LOCAL_BINDING is the default binding. Calls of local proxies do not need
+ * to be serialized, the arguments are moved to the stub dispatcher.
+ *
+ * Replies and events of local proxies created for a connection id are
+ * delivered by a dispatcher shared by all proxies of that connection, those
+ * of proxies created for a MainLoopContext by that context. Stub calls are
+ * dispatched per service.
+ *
+ * Local proxies are provided per interface by registering a proxy create
+ * function. Interfaces without create function, and instances without a
+ * local stub, are still handled by the other bindings.
+ */
+class LocalFactory : public Factory {
+public:
+    /**
+     * Creates the local proxy for the stub at the given address. The stub
+     * dispatcher executes the stub calls, the proxy dispatcher, if not empty,
+     * must be used to deliver replies and events to the proxy. The function
+     * should only keep a weak reference to the stub to notice its
+     * unregistration.
+     */
+    typedef std::function<std::shared_ptr<Proxy>(const Address &,
+                                                 const std::shared_ptr<StubBase> &,
+                                                 const std::shared_ptr<LocalDispatcher> &,
+                                                 const std::shared_ptr<LocalDispatcher> &)> ProxyCreateFunction;
+
+    COMMONAPI_EXPORT static std::shared_ptr<LocalFactory> get();
+
+    COMMONAPI_EXPORT void registerProxyCreateMethod(const std::string &_interface,
+                                                    ProxyCreateFunction _function);
+
+    COMMONAPI_EXPORT std::shared_ptr<StubBase> getStub(const Address &_address);
+
+    COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &_domain,
+                                                        const std::string &_interface,
+                                                        const std::string &_instance,
+                                                        const ConnectionId_t &_connectionId);
+
+    COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &_domain,
+                                                        const std::string &_interface,
+                                                        const std::string &_instance,
+                                                        std::shared_ptr<MainLoopContext> _context);
+
+    COMMONAPI_EXPORT bool registerStub(const std::string &_domain,
+                                       const std::string &_interface,
+                                       const std::string &_instance,
+                                       std::shared_ptr<StubBase> _stub,
+                                       const ConnectionId_t &_connectionId);
+
+    COMMONAPI_EXPORT bool registerStub(const std::string &_domain,
+                                       const std::string &_interface,
+                                       const std::string &_instance,
+                                       std::shared_ptr<StubBase> _stub,
+                                       std::shared_ptr<MainLoopContext> _context);
+
+    COMMONAPI_EXPORT bool unregisterStub(const std::string &_domain,
+                                         const std::string &_interface,
+                                         const std::string &_instance);
+
+private:
+    struct Service {
+        std::shared_ptr<StubBase> stub_;
+        std::shared_ptr<LocalDispatcher> dispatcher_;
+    };
+
+    std::shared_ptr<Proxy> createLocalProxy(const std::string &_domain,
+                                            const std::string &_interface,
+                                            const std::string &_instance,
+                                            const std::shared_ptr<LocalDispatcher> &_proxyDispatcher);
+
+    std::shared_ptr<LocalDispatcher> getDispatcher(const ConnectionId_t &_connectionId);
+
+    bool addService(const std::string &_domain,
+                    const std::string &_interface,
+                    const std::string &_instance,
+                    const std::shared_ptr<StubBase> &_stub,
+                    const std::shared_ptr<LocalDispatcher> &_dispatcher);
+
+    std::map<std::string, ProxyCreateFunction> proxyCreateFunctions_;
+    std::map<Address, Service> services_;
+    std::map<ConnectionId_t, std::weak_ptr<LocalDispatcher>> dispatchers_;
+    std::mutex mutex_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_LOCALFACTORY_HPP_
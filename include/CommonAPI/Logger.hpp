@@ -10,6 +10,7 @@
 #include <dlt/dlt.h>
 #endif
 
+#include <atomic>
 #include <cstdint>
 #include <fstream>
 #include <memory>
@@ -125,7 +126,7 @@ public:
     template<typename... LogEntries_>
     COMMONAPI_EXPORT static void log(Level _level, LogEntries_... _entries) {
 #if defined(USE_CONSOLE) || defined(USE_FILE) || defined(USE_DLT)
-        if (_level < maximumLogLevel_) {
+        if (_level < maximumLogLevel_.load(std::memory_order_relaxed)) {
             std::stringstream buffer;
             log_intern(buffer, _entries...);
             Logger::get()->doLog(_level, buffer.str());
@@ -136,6 +137,10 @@ public:
 #endif
     }
 
+    /**
+     * \brief Sets the log targets and the log level. May be called again
+     *        at any time, changes apply to all following messages.
+     */
     COMMONAPI_EXPORT static void init(bool, const std::string &, bool, const std::string &);
 
 private:
@@ -169,16 +174,17 @@ private:
     static std::mutex mutex_;
 #endif
 #if defined(USE_CONSOLE) || defined(USE_FILE) || defined(USE_DLT)
-    static Level maximumLogLevel_;
+    static std::atomic<Level> maximumLogLevel_;
 #endif
 #ifdef USE_CONSOLE
-    static bool useConsole_;
+    static std::atomic<bool> useConsole_;
 #endif
 #ifdef USE_FILE
     static std::shared_ptr<std::ofstream> file_;
+    static std::string fileName_;
 #endif
 #ifdef USE_DLT
-    static bool useDlt_;
+    static std::atomic<bool> useDlt_;
     DLT_DECLARE_CONTEXT(dlt_);
 #endif
 };
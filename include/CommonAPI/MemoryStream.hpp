@@ -0,0 +1,410 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_MEMORYSTREAM_HPP_
+#define COMMONAPI_MEMORYSTREAM_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <CommonAPI/ByteBuffer.hpp>
+#include <CommonAPI/InputStream.hpp>
+#include <CommonAPI/OutputStream.hpp>
+
+namespace CommonAPI {
+
+/*
+ * The memory streams use a compact, deployment independent format that is
+ * only meant to be exchanged between processes on the same host:
+ *
+ * - Arithmetic values are written in host byte order without padding.
+ * - Strings, vectors and maps are prefixed by their element count (uint32).
+ * - Variants are prefixed by their type index (uint8).
+ * - Polymorphic structs are prefixed by their serial (uint32).
+ *
+ * Vectors of arithmetic values are written and read as one block.
+ */
+
+/**
+ * \brief Serializes values into memory.
+ *
+ * The stream either writes into a fixed memory region, e.g. a shared memory
+ * segment, or appends to a ByteBuffer. Writing beyond the end of a fixed
+ * region sets the error flag, everything written afterwards is dropped.
+ */
+class MemoryOutputStream : public OutputStream<MemoryOutputStream> {
+public:
+    MemoryOutputStream(uint8_t *_data, std::size_t _capacity)
+        : data_(_data), capacity_(_capacity), size_(0), buffer_(nullptr), hasError_(false) {
+    }
+
+    MemoryOutputStream(ByteBuffer &_buffer)
+        : data_(nullptr), capacity_(0), size_(0), buffer_(&_buffer), hasError_(false) {
+    }
+
+    template<class Deployment_, typename Type_>
+    typename std::enable_if<std::is_arithmetic<Type_>::value, MemoryOutputStream &>::type
+    writeValue(const Type_ &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        write(&_value, sizeof(Type_));
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryOutputStream &writeValue(const std::string &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        writeSize(_value.size());
+        write(_value.data(), _value.size());
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryOutputStream &writeValue(const Version &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        write(&_value.Major, sizeof(_value.Major));
+        write(&_value.Minor, sizeof(_value.Minor));
+        return (*this);
+    }
+
+    template<class Deployment_, typename Base_>
+    MemoryOutputStream &writeValue(const Enumeration<Base_> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        write(&_value.value_, sizeof(Base_));
+        return (*this);
+    }
+
+    template<class Deployment_, typename... Types_>
+    MemoryOutputStream &writeValue(const Struct<Types_...> &_value, const Deployment_ *_depl = nullptr) {
+        const auto itsSize(std::tuple_size<std::tuple<Types_...>>::value);
+        StructWriter<itsSize - 1, MemoryOutputStream, Struct<Types_...>, Deployment_>{}(
+            (*this), _value, _depl);
+        return (*this);
+    }
+
+    template<class Deployment_, class PolymorphicStruct_>
+    MemoryOutputStream &writeValue(const std::shared_ptr<PolymorphicStruct_> &_value,
+                                   const Deployment_ *_depl = nullptr) {
+        if (_value) {
+            uint32_t itsSerial(_value->getSerial());
+            write(&itsSerial, sizeof(itsSerial));
+            _value->template writeValue<>((*this), _depl);
+        } else {
+            hasError_ = true;
+        }
+        return (*this);
+    }
+
+    template<class Deployment_, typename... Types_>
+    MemoryOutputStream &writeValue(const Variant<Types_...> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint8_t itsType(_value.getValueType());
+        write(&itsType, sizeof(itsType));
+
+        OutputStreamWriteVisitor<MemoryOutputStream> visitor(*this);
+        ApplyVoidVisitor<
+            OutputStreamWriteVisitor<MemoryOutputStream>, Variant<Types_...>, Types_...
+        >::visit(visitor, _value);
+        return (*this);
+    }
+
+    template<class Deployment_, typename ElementType_>
+    MemoryOutputStream &writeValue(const std::vector<ElementType_> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        writeSize(_value.size());
+        writeElements(_value, std::is_arithmetic<ElementType_>());
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryOutputStream &writeValue(const std::vector<bool> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        writeSize(_value.size());
+        for (bool element : _value)
+            writeValue<EmptyDeployment>(element);
+        return (*this);
+    }
+
+    template<class Deployment_, typename KeyType_, typename ValueType_, typename HasherType_>
+    MemoryOutputStream &writeValue(const std::unordered_map<KeyType_, ValueType_, HasherType_> &_value,
+                                   const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        writeSize(_value.size());
+        for (auto &element : _value) {
+            writeValue<EmptyDeployment>(element.first);
+            writeValue<EmptyDeployment>(element.second);
+        }
+        return (*this);
+    }
+
+    bool hasError() const {
+        return hasError_;
+    }
+
+    /**
+     * \brief Returns the number of bytes written so far.
+     */
+    std::size_t getSize() const {
+        return size_;
+    }
+
+private:
+    void write(const void *_data, std::size_t _size) {
+        if (hasError_ || 0 == _size)
+            return;
+
+        if (buffer_) {
+            const uint8_t *itsData = static_cast<const uint8_t *>(_data);
+            buffer_->insert(buffer_->end(), itsData, itsData + _size);
+        } else if (_size <= capacity_ - size_) {
+            std::memcpy(data_ + size_, _data, _size);
+        } else {
+            hasError_ = true;
+            return;
+        }
+        size_ += _size;
+    }
+
+    void writeSize(std::size_t _size) {
+        if (_size > UINT32_MAX) {
+            hasError_ = true;
+            return;
+        }
+        uint32_t itsSize(static_cast<uint32_t>(_size));
+        write(&itsSize, sizeof(itsSize));
+    }
+
+    template<typename ElementType_>
+    void writeElements(const std::vector<ElementType_> &_value, std::true_type) {
+        write(_value.data(), _value.size() * sizeof(ElementType_));
+    }
+
+    template<typename ElementType_>
+    void writeElements(const std::vector<ElementType_> &_value, std::false_type) {
+        for (auto &element : _value)
+            writeValue<EmptyDeployment>(element);
+    }
+
+    uint8_t *data_;
+    std::size_t capacity_;
+    std::size_t size_;
+    ByteBuffer *buffer_;
+    bool hasError_;
+};
+
+/**
+ * \brief Deserializes values written by a MemoryOutputStream.
+ *
+ * The stream reads directly from the given memory, which must stay valid
+ * while the stream is used. Reading beyond its end sets the error flag.
+ */
+class MemoryInputStream : public InputStream<MemoryInputStream> {
+public:
+    MemoryInputStream(const uint8_t *_data, std::size_t _size)
+        : data_(_data), size_(_size), position_(0), hasError_(false) {
+    }
+
+    template<class Deployment_, typename Type_>
+    typename std::enable_if<std::is_arithmetic<Type_>::value, MemoryInputStream &>::type
+    readValue(Type_ &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        if (!read(&_value, sizeof(Type_)))
+            _value = Type_();
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryInputStream &readValue(std::string &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint32_t itsSize(readSize(1));
+        const uint8_t *itsData = consume(itsSize);
+        if (itsData) {
+            _value.assign(reinterpret_cast<const char *>(itsData), itsSize);
+        } else {
+            _value.clear();
+        }
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryInputStream &readValue(Version &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        readValue<EmptyDeployment>(_value.Major);
+        readValue<EmptyDeployment>(_value.Minor);
+        return (*this);
+    }
+
+    template<class Deployment_, typename Base_>
+    MemoryInputStream &readValue(Enumeration<Base_> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        readValue<EmptyDeployment>(_value.value_);
+        return (*this);
+    }
+
+    template<class Deployment_, typename... Types_>
+    MemoryInputStream &readValue(Struct<Types_...> &_value, const Deployment_ *_depl = nullptr) {
+        const auto itsSize(std::tuple_size<std::tuple<Types_...>>::value);
+        StructReader<itsSize - 1, MemoryInputStream, Struct<Types_...>, Deployment_>{}(
+            (*this), _value, _depl);
+        return (*this);
+    }
+
+    template<class Deployment_, class PolymorphicStruct_>
+    MemoryInputStream &readValue(std::shared_ptr<PolymorphicStruct_> &_value,
+                                 const Deployment_ *_depl = nullptr) {
+        uint32_t itsSerial(0);
+        readValue<EmptyDeployment>(itsSerial);
+        if (!hasError_) {
+            _value = PolymorphicStruct_::create(itsSerial);
+            if (_value) {
+                _value->template readValue<>((*this), _depl);
+            } else {
+                hasError_ = true;
+            }
+        }
+        return (*this);
+    }
+
+    template<class Deployment_, typename... Types_>
+    MemoryInputStream &readValue(Variant<Types_...> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint8_t itsType(0);
+        readValue<EmptyDeployment>(itsType);
+        if (hasError_ || itsType == 0 || itsType > _value.getMaxValueType()) {
+            hasError_ = true;
+            return (*this);
+        }
+
+        if (_value.hasValue()) {
+            DeleteVisitor<Variant<Types_...>::maxSize> visitor(_value.valueStorage_);
+            ApplyVoidVisitor<
+                DeleteVisitor<Variant<Types_...>::maxSize>, Variant<Types_...>, Types_...
+            >::visit(visitor, _value);
+        }
+        _value.valueType_ = itsType;
+
+        InputStreamReadVisitor<MemoryInputStream, Types_...> visitor(*this, _value);
+        ApplyVoidVisitor<
+            InputStreamReadVisitor<MemoryInputStream, Types_...>, Variant<Types_...>, Types_...
+        >::visit(visitor, _value);
+        return (*this);
+    }
+
+    template<class Deployment_, typename ElementType_>
+    MemoryInputStream &readValue(std::vector<ElementType_> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint32_t itsSize(readSize(std::is_arithmetic<ElementType_>::value ? sizeof(ElementType_) : 1));
+        readElements(_value, itsSize, std::is_arithmetic<ElementType_>());
+        return (*this);
+    }
+
+    template<class Deployment_>
+    MemoryInputStream &readValue(std::vector<bool> &_value, const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint32_t itsSize(readSize(sizeof(bool)));
+        _value.clear();
+        _value.reserve(itsSize);
+        for (uint32_t i = 0; i < itsSize && !hasError_; i++) {
+            bool itsElement(false);
+            readValue<EmptyDeployment>(itsElement);
+            _value.push_back(itsElement);
+        }
+        return (*this);
+    }
+
+    template<class Deployment_, typename KeyType_, typename ValueType_, typename HasherType_>
+    MemoryInputStream &readValue(std::unordered_map<KeyType_, ValueType_, HasherType_> &_value,
+                                 const Deployment_ *_depl = nullptr) {
+        (void)_depl;
+        uint32_t itsSize(readSize(2));
+        _value.clear();
+        for (uint32_t i = 0; i < itsSize && !hasError_; i++) {
+            KeyType_ itsKey;
+            ValueType_ itsValue;
+            readValue<EmptyDeployment>(itsKey);
+            readValue<EmptyDeployment>(itsValue);
+            if (!hasError_)
+                _value.insert(std::make_pair(std::move(itsKey), std::move(itsValue)));
+        }
+        return (*this);
+    }
+
+    bool hasError() const {
+        return hasError_;
+    }
+
+    /**
+     * \brief Returns the number of bytes that were not read yet.
+     */
+    std::size_t getRemaining() const {
+        return (size_ - position_);
+    }
+
+private:
+    const uint8_t *consume(std::size_t _size) {
+        if (hasError_ || _size > size_ - position_) {
+            hasError_ = true;
+            return nullptr;
+        }
+        const uint8_t *itsData = data_ + position_;
+        position_ += _size;
+        return itsData;
+    }
+
+    bool read(void *_data, std::size_t _size) {
+        const uint8_t *itsData = consume(_size);
+        if (itsData)
+            std::memcpy(_data, itsData, _size);
+        return (nullptr != itsData);
+    }
+
+    // Reads an element count and checks it against the remaining bytes to
+    // not allocate huge amounts of memory for corrupt input.
+    uint32_t readSize(std::size_t _minimumElementSize) {
+        uint32_t itsSize(0);
+        if (read(&itsSize, sizeof(itsSize))
+                && itsSize > (size_ - position_) / _minimumElementSize) {
+            hasError_ = true;
+            itsSize = 0;
+        }
+        return itsSize;
+    }
+
+    template<typename ElementType_>
+    void readElements(std::vector<ElementType_> &_value, uint32_t _size, std::true_type) {
+        _value.resize(_size);
+        if (_size > 0 && !read(_value.data(), _size * sizeof(ElementType_)))
+            _value.clear();
+    }
+
+    template<typename ElementType_>
+    void readElements(std::vector<ElementType_> &_value, uint32_t _size, std::false_type) {
+        _value.clear();
+        _value.reserve(_size);
+        for (uint32_t i = 0; i < _size && !hasError_; i++) {
+            ElementType_ itsElement;
+            readValue<EmptyDeployment>(itsElement);
+            _value.push_back(std::move(itsElement));
+        }
+    }
+
+    const uint8_t *data_;
+    std::size_t size_;
+    std::size_t position_;
+    bool hasError_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_MEMORYSTREAM_HPP_
@@ -10,18 +10,159 @@
 #ifndef COMMONAPI_PROXY_MANAGER_HPP_
 #define COMMONAPI_PROXY_MANAGER_HPP_
 
+#include <chrono>
 #include <functional>
 #include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 #include <CommonAPI/Event.hpp>
+#include <CommonAPI/Future.hpp>
 #include <CommonAPI/Proxy.hpp>
 #include <CommonAPI/Types.hpp>
 #include <CommonAPI/Runtime.hpp>
 
 namespace CommonAPI {
 
+/**
+ * \brief Proxies for all available instances of a ProxyManager.
+ *
+ * Created by ProxyManager::buildProxySet. Proxies are added and removed as
+ * the InstanceAvailabilityStatusChangedEvent reports instances, new proxies
+ * are built on the notifying thread. A proxy set must not outlive its
+ * ProxyManager and must not be destroyed by its changed handler.
+ */
+template<typename Proxy_>
+class ProxySet {
+public:
+    typedef std::map<std::string, std::shared_ptr<Proxy_>> Proxies;
+
+    /**
+     * \brief Called for each added proxy, and with nullptr for each
+     *        removed instance.
+     */
+    typedef std::function<void(const std::string &, const std::shared_ptr<Proxy_> &)> ChangedHandler;
+
+    typedef Event<std::string, AvailabilityStatus> AvailabilityEvent;
+    typedef std::function<std::shared_ptr<Proxy_>(const std::string &)> Builder;
+
+    ProxySet(AvailabilityEvent &_event, Builder _builder, ChangedHandler _handler)
+        : event_(_event), builder_(_builder), handler_(_handler),
+          subscription_(0), isSubscribed_(false), isInitializing_(true) {
+    }
+
+    ~ProxySet() {
+        if (isSubscribed_)
+            event_.unsubscribe(subscription_);
+    }
+
+    ProxySet(const ProxySet &) = delete;
+    ProxySet &operator=(const ProxySet &) = delete;
+
+    Proxies getProxies() const {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        return proxies_;
+    }
+
+    std::shared_ptr<Proxy_> getProxy(const std::string &_instance) const {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        auto itsProxy = proxies_.find(_instance);
+        return (itsProxy != proxies_.end() ? itsProxy->second : nullptr);
+    }
+
+private:
+    void subscribe(const std::weak_ptr<ProxySet> &_self) {
+        subscription_ = event_.subscribe(
+            [_self](const std::string &_instance, const AvailabilityStatus &_status) {
+                std::shared_ptr<ProxySet> itsSelf = _self.lock();
+                if (itsSelf)
+                    itsSelf->onChanged(_instance, _status);
+            });
+        isSubscribed_ = true;
+    }
+
+    // Instances that changed while the initial proxies were built keep
+    // the state reported by the event.
+    void initialize(const std::vector<std::string> &_instances,
+                    const std::vector<std::shared_ptr<Proxy_>> &_proxies) {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        for (std::size_t i = 0; i < _instances.size(); i++) {
+            if (_proxies[i] && changed_.find(_instances[i]) == changed_.end())
+                proxies_[_instances[i]] = _proxies[i];
+        }
+        changed_.clear();
+        isInitializing_ = false;
+    }
+
+    void onChanged(const std::string &_instance, const AvailabilityStatus &_status) {
+        std::shared_ptr<Proxy_> itsProxy;
+        {
+            std::lock_guard<std::mutex> itsLock(mutex_);
+            if (isInitializing_)
+                changed_.insert(_instance);
+
+            bool isKnown = (proxies_.find(_instance) != proxies_.end());
+            if (_status == AvailabilityStatus::AVAILABLE) {
+                if (isKnown)
+                    return;
+            } else {
+                if (!isKnown)
+                    return;
+                proxies_.erase(_instance);
+            }
+        }
+
+        // Events are delivered one after the other, no other thread adds
+        // or removes proxies meanwhile.
+        if (_status == AvailabilityStatus::AVAILABLE) {
+            itsProxy = builder_(_instance);
+            if (!itsProxy)
+                return;
+            std::lock_guard<std::mutex> itsLock(mutex_);
+            proxies_[_instance] = itsProxy;
+        }
+
+        if (handler_)
+            handler_(_instance, itsProxy);
+    }
+
+    AvailabilityEvent &event_;
+    Builder builder_;
+    ChangedHandler handler_;
+    typename AvailabilityEvent::Subscription subscription_;
+    bool isSubscribed_;
+
+    mutable std::mutex mutex_;
+    Proxies proxies_;
+    bool isInitializing_;
+    std::set<std::string> changed_;
+
+friend class ProxyManager;
+};
+
+/**
+ * \brief Implemented additionally to ProxyManager by the proxy managers of
+ *        bindings that fulfill a CommonAPI::Future directly.
+ *
+ * The ProxyManager variants returning a CommonAPI::Future look it up. It is
+ * kept apart to leave the vtable of ProxyManager unchanged.
+ */
+class ProxyManagerLightSupport {
+public:
+    typedef std::function<void(const CallStatus &, const std::vector<std::string> &)> GetAvailableInstancesCallback;
+    typedef std::function<void(const CallStatus &, const AvailabilityStatus &)> GetInstanceAvailabilityStatusCallback;
+
+    virtual ~ProxyManagerLightSupport() {}
+
+    virtual Future<CallStatus> getAvailableInstancesAsyncLight(GetAvailableInstancesCallback _callback) = 0;
+    virtual Future<CallStatus> getInstanceAvailabilityStatusAsyncLight(const std::string &_instance,
+                                                                       GetInstanceAvailabilityStatusCallback _callback) = 0;
+};
+
 class ProxyManager {
 public:
     typedef std::function<void(const CallStatus &, const std::vector<std::string> &)> GetAvailableInstancesCallback;
@@ -49,8 +190,72 @@ public:
     virtual std::future<CallStatus> getInstanceAvailabilityStatusAsync(const std::string&,
                                                                        GetInstanceAvailabilityStatusCallback callback) = 0;
 
+    // Variants returning a CommonAPI::Future. Proxy managers implementing
+    // ProxyManagerLightSupport fulfill it directly, for all others the
+    // std::future based calls are adapted.
+    Future<CallStatus> getAvailableInstancesAsyncLight(GetAvailableInstancesCallback _callback) {
+        ProxyManagerLightSupport *support = dynamic_cast<ProxyManagerLightSupport *>(this);
+        if (support)
+            return support->getAvailableInstancesAsyncLight(_callback);
+
+        Promise<CallStatus> promise;
+        Future<CallStatus> future = promise.getFuture();
+        (void)getAvailableInstancesAsync(
+            [_callback, promise](const CallStatus &_status,
+                                 const std::vector<std::string> &_instances) mutable {
+                if (_callback)
+                    _callback(_status, _instances);
+                promise.setValue(_status);
+            });
+        return future;
+    }
+
+    Future<CallStatus> getInstanceAvailabilityStatusAsyncLight(const std::string &_instance,
+                                                               GetInstanceAvailabilityStatusCallback _callback) {
+        ProxyManagerLightSupport *support = dynamic_cast<ProxyManagerLightSupport *>(this);
+        if (support)
+            return support->getInstanceAvailabilityStatusAsyncLight(_instance, _callback);
+
+        Promise<CallStatus> promise;
+        Future<CallStatus> future = promise.getFuture();
+        (void)getInstanceAvailabilityStatusAsync(
+            _instance,
+            [_callback, promise](const CallStatus &_status,
+                                 const AvailabilityStatus &_availabilityStatus) mutable {
+                if (_callback)
+                    _callback(_status, _availabilityStatus);
+                promise.setValue(_status);
+            });
+        return future;
+    }
+
     virtual InstanceAvailabilityStatusChangedEvent& getInstanceAvailabilityStatusChangedEvent() = 0;
 
+    /**
+     * \brief Cached variants of getAvailableInstances and
+     *        getInstanceAvailabilityStatus.
+     *
+     * The first call subscribes to the InstanceAvailabilityStatusChangedEvent
+     * and queries the available instances once. Afterwards, the event keeps
+     * the cache current and queries are answered locally. The binding is
+     * asked again after the cache timeout expired or the event reported an
+     * error. Concurrent queries on a cold cache share a single request.
+     * The cache is kept outside of the proxy manager and is released when
+     * its InstanceAvailabilityStatusChangedEvent is destroyed.
+     */
+    COMMONAPI_EXPORT void getCachedAvailableInstances(CallStatus &_status,
+                                                      std::vector<std::string> &_instances);
+    COMMONAPI_EXPORT void getCachedInstanceAvailabilityStatus(const std::string &_instance,
+                                                              CallStatus &_status,
+                                                              AvailabilityStatus &_availabilityStatus);
+
+    /**
+     * \brief Sets the time after which the cached instances are queried
+     *        again. A timeout of zero lets the cache rely on the event only.
+     */
+    COMMONAPI_EXPORT void setDiscoveryCacheTimeout(std::chrono::milliseconds _timeout);
+    COMMONAPI_EXPORT void invalidateDiscoveryCache();
+
     template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
     std::shared_ptr<ProxyClass_<AttributeExtensions_...> >
     buildProxy(const std::string &_instance, const ConnectionId_t& _connectionId = DEFAULT_CONNECTION_ID) {
@@ -61,11 +266,94 @@ public:
         return NULL;
     }
 
+    /**
+     * \brief Builds proxies for the given instances in parallel. The result
+     *        contains an entry for each instance, nullptr if the proxy
+     *        could not be built. Libraries are resolved once per batch.
+     */
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    std::vector<std::shared_ptr<ProxyClass_<AttributeExtensions_...>>>
+    buildProxies(const std::vector<std::string> &_instances,
+                 const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        typedef ProxyClass_<AttributeExtensions_...> proxy_t;
+        std::vector<std::shared_ptr<Proxy>> proxies
+            = createProxies(getDomain(), getInterface(), _instances,
+                            (DEFAULT_CONNECTION_ID == _connectionId) ? getConnectionId() : _connectionId);
+
+        std::vector<std::shared_ptr<proxy_t>> result;
+        result.reserve(proxies.size());
+        for (auto &proxy : proxies)
+            result.push_back(proxy ? std::make_shared<proxy_t>(proxy) : nullptr);
+        return result;
+    }
+
+    /**
+     * \brief Builds proxies for all currently available instances, as
+     *        reported by getCachedAvailableInstances.
+     */
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    std::map<std::string, std::shared_ptr<ProxyClass_<AttributeExtensions_...>>>
+    buildAllProxies(const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        std::map<std::string, std::shared_ptr<ProxyClass_<AttributeExtensions_...>>> result;
+
+        CallStatus status;
+        std::vector<std::string> instances;
+        getCachedAvailableInstances(status, instances);
+        if (status != CallStatus::SUCCESS)
+            return result;
+
+        auto proxies = buildProxies<ProxyClass_, AttributeExtensions_...>(instances, _connectionId);
+        for (std::size_t i = 0; i < instances.size(); i++) {
+            if (proxies[i])
+                result[instances[i]] = proxies[i];
+        }
+        return result;
+    }
+
+    /**
+     * \brief Builds proxies for all currently available instances and keeps
+     *        them in sync with the InstanceAvailabilityStatusChangedEvent.
+     */
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    std::shared_ptr<ProxySet<ProxyClass_<AttributeExtensions_...>>>
+    buildProxySet(typename ProxySet<ProxyClass_<AttributeExtensions_...>>::ChangedHandler _handler = nullptr,
+                  const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        typedef ProxyClass_<AttributeExtensions_...> proxy_t;
+        std::shared_ptr<ProxySet<proxy_t>> proxySet = std::make_shared<ProxySet<proxy_t>>(
+            getInstanceAvailabilityStatusChangedEvent(),
+            [this, _connectionId](const std::string &_instance) {
+                return buildProxy<ProxyClass_, AttributeExtensions_...>(_instance, _connectionId);
+            },
+            _handler);
+
+        // Subscribe first to not miss instances that appear meanwhile
+        proxySet->subscribe(proxySet);
+
+        CallStatus status;
+        std::vector<std::string> instances;
+        getCachedAvailableInstances(status, instances);
+        if (status != CallStatus::SUCCESS)
+            instances.clear();
+        proxySet->initialize(instances, buildProxies<ProxyClass_, AttributeExtensions_...>(instances, _connectionId));
+
+        return proxySet;
+    }
+
 protected:
     COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &,
                                        const std::string &,
                                        const std::string &,
                                        const ConnectionId_t &_connection) const;
+    COMMONAPI_EXPORT std::vector<std::shared_ptr<Proxy>> createProxies(const std::string &,
+                                       const std::string &,
+                                       const std::vector<std::string> &,
+                                       const ConnectionId_t &_connection) const;
+
+private:
+    struct DiscoveryCache;
+
+    std::shared_ptr<DiscoveryCache> getDiscoveryCache();
+    bool refreshDiscoveryCache(CallStatus &_status);
 };
 
 } // namespace CommonAPI
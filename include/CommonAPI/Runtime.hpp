@@ -10,32 +10,75 @@
 #ifndef COMMONAPI_RUNTIME_HPP_
 #define COMMONAPI_RUNTIME_HPP_
 
+#include <atomic>
+#include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <vector>
 
+#include <CommonAPI/Address.hpp>
 #include <CommonAPI/AttributeExtension.hpp>
 #include <CommonAPI/Export.hpp>
 #include <CommonAPI/Factory.hpp>
+#include <CommonAPI/Future.hpp>
+#include <CommonAPI/StringView.hpp>
 #include <CommonAPI/Types.hpp>
 
 namespace CommonAPI {
 
 static const ConnectionId_t DEFAULT_CONNECTION_ID = "";
+static const std::string LOCAL_BINDING = "local";
 
+class ConfigurationWatch;
+class Executor;
 class MainLoopContext;
 class Proxy;
 class ProxyManager;
+class RoutingTable;
 class StubBase;
+class ThreadPool;
+
+typedef std::function<void(const std::string &, const std::string &)> PropertyChangedCallback;
+typedef std::list<PropertyChangedCallback>::iterator PropertyChangedSubscription;
 
 class Runtime {
 public:
+    /**
+     * \brief Returns the value of a property or an empty string.
+     *
+     * Properties may be read and written from any thread. Reading does not
+     * lock as long as no property was changed since the calling thread's
+     * last read.
+     */
     COMMONAPI_EXPORT static std::string getProperty(const std::string &_name);
+    COMMONAPI_EXPORT static std::string getProperty(const StringView &_name);
+    inline static std::string getProperty(const char *_name) { return getProperty(StringView(_name)); }
     COMMONAPI_EXPORT static void setProperty(const std::string &_name, const std::string &_value);
 
+    /**
+     * \brief Registers for changes of property values.
+     *
+     * The callback receives name and new value of each changed property. It
+     * is called from the thread that changed the property, without any lock
+     * held, and may set properties or (un)subscribe itself. A callback that
+     * is unsubscribed while another thread notifies a change may still be
+     * called once for that change.
+     */
+    COMMONAPI_EXPORT static PropertyChangedSubscription subscribeForPropertyChanges(PropertyChangedCallback _callback);
+    COMMONAPI_EXPORT static void unsubscribeForPropertyChanges(PropertyChangedSubscription _subscription);
+
     COMMONAPI_EXPORT static std::shared_ptr<Runtime> get();
 
+    /**
+     * \brief Returns the runtime like get(), without touching the reference
+     *        count. The runtime lives until the end of the program, use this
+     *        where get() is called frequently from many threads.
+     */
+    COMMONAPI_EXPORT static Runtime &instance();
+
     COMMONAPI_EXPORT Runtime();
     COMMONAPI_EXPORT virtual ~Runtime();
 
@@ -78,6 +121,82 @@ public:
         return nullptr;
     }
 
+    /**
+     * \brief Builds a proxy on the runtime's thread pool.
+     *
+     * The returned future receives the proxy, or a null pointer if it could
+     * not be built. Builds still queued when the runtime is destroyed are
+     * dropped, their futures are never set.
+     */
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    COMMONAPI_EXPORT Future<std::shared_ptr<
+        ProxyClass_<AttributeExtensions_...>
+    >>
+    buildProxyAsync(const std::string &_domain,
+                    const std::string &_instance,
+                    const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        typedef ProxyClass_<AttributeExtensions_...> proxy_t;
+        Promise<std::shared_ptr<proxy_t>> promise;
+        Future<std::shared_ptr<proxy_t>> future = promise.getFuture();
+        createProxyAsync(_domain,
+                         proxy_t::getInterface(),
+                         _instance,
+                         _connectionId,
+                         [promise](std::shared_ptr<Proxy> _proxy) mutable {
+                             promise.setValue(_proxy ? std::make_shared<proxy_t>(_proxy) : nullptr);
+                         });
+        return future;
+    }
+
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    COMMONAPI_EXPORT Future<std::shared_ptr<
+        ProxyClass_<AttributeExtensions_...>
+    >>
+    buildProxyAsync(const std::string &_domain,
+                    const std::string &_instance,
+                    std::shared_ptr<MainLoopContext> _context) {
+        typedef ProxyClass_<AttributeExtensions_...> proxy_t;
+        Promise<std::shared_ptr<proxy_t>> promise;
+        Future<std::shared_ptr<proxy_t>> future = promise.getFuture();
+        createProxyAsync(_domain,
+                         proxy_t::getInterface(),
+                         _instance,
+                         _context,
+                         [promise](std::shared_ptr<Proxy> _proxy) mutable {
+                             promise.setValue(_proxy ? std::make_shared<proxy_t>(_proxy) : nullptr);
+                         });
+        return future;
+    }
+
+    /**
+     * \brief Builds proxies for several instances of one interface in parallel.
+     *
+     * The interface library is resolved and loaded once before the proxies
+     * are built on the runtime's thread pool. The calling thread takes part
+     * in building. The returned vector has the same order as the instances,
+     * an element is a null pointer if its proxy could not be built.
+     */
+    template<template<typename ...> class ProxyClass_, typename ... AttributeExtensions_>
+    COMMONAPI_EXPORT std::vector<std::shared_ptr<
+        ProxyClass_<AttributeExtensions_...>
+    >>
+    buildProxies(const std::string &_domain,
+                 const std::vector<std::string> &_instances,
+                 const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        typedef ProxyClass_<AttributeExtensions_...> proxy_t;
+        std::vector<std::shared_ptr<Proxy>> proxies
+            = createProxies(_domain,
+                            proxy_t::getInterface(),
+                            _instances,
+                            _connectionId);
+
+        std::vector<std::shared_ptr<proxy_t>> result;
+        result.reserve(proxies.size());
+        for (auto &proxy : proxies)
+            result.push_back(proxy ? std::make_shared<proxy_t>(proxy) : nullptr);
+        return result;
+    }
+
     template <template<typename ...> class ProxyClass_, template<typename> class AttributeExtension_>
     COMMONAPI_EXPORT std::shared_ptr<typename DefaultAttributeProxyHelper<ProxyClass_, AttributeExtension_>::class_t>
     buildProxyWithDefaultAttributeExtension(const std::string &_domain,
@@ -126,6 +245,39 @@ public:
         return registerStub(_domain, Stub_::StubInterface::getInterface(), _instance, _service, _context);
     }
 
+    /**
+     * \brief Registers a service whose calls are executed by the given
+     *        executor instead of the dispatching thread of the binding.
+     *        If the registration fails, the service keeps no executor.
+     */
+    template<typename Stub_>
+    COMMONAPI_EXPORT bool registerService(const std::string &_domain,
+                         const std::string &_instance,
+                         std::shared_ptr<Stub_> _service,
+                         std::shared_ptr<Executor> _executor,
+                         const ConnectionId_t &_connectionId = DEFAULT_CONNECTION_ID) {
+        _service->setExecutor(_executor, std::shared_ptr<const StubBase>(_service));
+        if (!registerStub(_domain, Stub_::StubInterface::getInterface(), _instance, _service, _connectionId)) {
+            _service->setExecutor(nullptr);
+            return false;
+        }
+        return true;
+    }
+
+    template<typename Stub_>
+    COMMONAPI_EXPORT bool registerService(const std::string &_domain,
+                         const std::string &_instance,
+                         std::shared_ptr<Stub_> _service,
+                         std::shared_ptr<Executor> _executor,
+                         std::shared_ptr<MainLoopContext> _context) {
+        _service->setExecutor(_executor, std::shared_ptr<const StubBase>(_service));
+        if (!registerStub(_domain, Stub_::StubInterface::getInterface(), _instance, _service, _context)) {
+            _service->setExecutor(nullptr);
+            return false;
+        }
+        return true;
+    }
+
     COMMONAPI_EXPORT bool unregisterService(const std::string &_domain,
                             const std::string &_interface,
                             const std::string &_instance) {
@@ -135,10 +287,48 @@ public:
     COMMONAPI_EXPORT bool registerFactory(const std::string &_ipc, std::shared_ptr<Factory> _factory);
     COMMONAPI_EXPORT bool unregisterFactory(const std::string &_ipc);
 
+    /**
+     * \brief Enables or disables sharing of binding proxies.
+     *
+     * If enabled, proxies built for the same address and connection share one
+     * binding proxy as long as at least one of them is alive. The cache only
+     * holds weak references. Proxies built for a MainLoopContext are never
+     * shared. Disabling the cache drops all entries.
+     */
+    COMMONAPI_EXPORT void setProxyCacheEnabled(bool _isEnabled);
+    COMMONAPI_EXPORT bool isProxyCacheEnabled() const;
+
+    /**
+     * \brief Returns the worker pool used for asynchronous and parallel
+     *        operations of the runtime. The pool is created on first use.
+     */
+    COMMONAPI_EXPORT std::shared_ptr<ThreadPool> getThreadPool();
+
+    /**
+     * \brief Reloads the configuration file whenever it was changed.
+     *
+     * Changes of the logging configuration apply immediately, changes of
+     * the proxy and stub library mappings to all following builds and
+     * registrations. The default binding, folder and preload settings are
+     * only read on startup. The file is watched by a Watch registered with
+     * the given context, or by a thread of the runtime if no context is
+     * given. Returns false if the file is already watched or cannot be
+     * watched, which is always the case on Windows.
+     */
+    COMMONAPI_EXPORT bool watchConfiguration(std::shared_ptr<MainLoopContext> _context = nullptr);
+    COMMONAPI_EXPORT void unwatchConfiguration();
+
+    /**
+     * \brief Reads the configuration file again. Returns false, and keeps
+     *        the current configuration, if the file cannot be read.
+     *        Libraries that failed to load are tried again afterwards.
+     */
+    COMMONAPI_EXPORT bool reloadConfiguration();
+
     inline const std::string &getDefaultBinding() const { return defaultBinding_; };
 
 private:
-    COMMONAPI_EXPORT bool readConfiguration();
+    COMMONAPI_EXPORT bool readConfiguration(bool _isReload);
     COMMONAPI_EXPORT bool splitAddress(const std::string &, std::string &, std::string &, std::string &);
 
     COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &, const std::string &, const std::string &,
@@ -146,6 +336,16 @@ private:
     COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &, const std::string &, const std::string &,
                                        std::shared_ptr<MainLoopContext>);
 
+    COMMONAPI_EXPORT void createProxyAsync(const std::string &, const std::string &, const std::string &,
+                                           const ConnectionId_t &,
+                                           std::function<void(std::shared_ptr<Proxy>)>);
+    COMMONAPI_EXPORT void createProxyAsync(const std::string &, const std::string &, const std::string &,
+                                           std::shared_ptr<MainLoopContext>,
+                                           std::function<void(std::shared_ptr<Proxy>)>);
+    COMMONAPI_EXPORT std::vector<std::shared_ptr<Proxy>> createProxies(const std::string &, const std::string &,
+                                                                       const std::vector<std::string> &,
+                                                                       const ConnectionId_t &);
+
     COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxyHelper(const std::string &, const std::string &, const std::string &,
                                              const ConnectionId_t &, bool);
     COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxyHelper(const std::string &, const std::string &, const std::string &,
@@ -165,6 +365,14 @@ private:
 
     COMMONAPI_EXPORT std::string getLibrary(const std::string &, const std::string &, const std::string &, bool);
     COMMONAPI_EXPORT bool loadLibrary(const std::string &);
+    COMMONAPI_EXPORT void preloadLibraries();
+
+    COMMONAPI_EXPORT std::shared_ptr<Factory> getRoute(const std::string &, const std::string &, const std::string &, bool) const;
+    COMMONAPI_EXPORT void addRoute(const std::string &, const std::string &, const std::string &, bool,
+                                   const std::shared_ptr<Factory> &);
+    COMMONAPI_EXPORT void clearRoutes();
+
+    void pruneProxies();
 
 private:
     std::string defaultBinding_;
@@ -172,15 +380,50 @@ private:
     std::string defaultConfig_;
 
     std::map<std::string, std::shared_ptr<Factory>> factories_;
+    // Loaded and stored atomically, libraries register it from any thread
     std::shared_ptr<Factory> defaultFactory_;
-    std::map<std::string, std::map<bool, std::string>> libraries_;
+
+    // Factory of the in-process binding. It is asked before all others and
+    // additionally to them. As it is used without locking, all factories
+    // ever registered for LOCAL_BINDING are kept.
+    std::atomic<Factory *> localFactory_;
+    std::vector<std::shared_ptr<Factory>> localFactories_;
+    // Library mappings are replaced as a whole when the configuration is
+    // reloaded. They are read and written by std::atomic_load/atomic_store.
+    struct Libraries;
+    std::shared_ptr<const Libraries> libraries_;
     std::set<std::string> loadedLibraries_; // Library name
+    std::set<std::string> failedLibraries_; // Library name
+    bool isPreloadEnabled_;
+
+    bool isProxyCacheEnabled_;
+    std::map<std::pair<Address, ConnectionId_t>, std::weak_ptr<Proxy>> proxies_;
+    // Expired entries are pruned once the cache grew to this size
+    std::size_t proxiesPruneSize_;
+
+    // Factories known to be responsible for domain, interface and connection.
+    // Readers take the current tables by std::atomic_load, without
+    // routesMutex_. Writers add to them or replace them under routesMutex_.
+    std::shared_ptr<RoutingTable> proxyRoutes_;
+    std::shared_ptr<RoutingTable> stubRoutes_;
+    std::mutex routesMutex_;
+
+    std::atomic<bool> isInitialized_;
 
     std::mutex mutex_;
     std::mutex factoriesMutex_;
     std::mutex loadMutex_;
+    mutable std::mutex proxiesMutex_;
+
+    // Stopped by ~Runtime, declared after the mutexes its tasks use
+    std::shared_ptr<ThreadPool> threadPool_;
+    std::mutex threadPoolMutex_;
+
+    std::string configFile_;
+    std::mutex configurationMutex_;
+    // Declared last to stop watching before anything else is destroyed
+    std::unique_ptr<ConfigurationWatch> configurationWatch_;
 
-    static std::map<std::string, std::string> properties_;
     static std::shared_ptr<Runtime> theRuntime__;
 
 friend class ProxyManager;
@@ -0,0 +1,146 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_SHMCHANNEL_HPP_
+#define COMMONAPI_SHMCHANNEL_HPP_
+
+#ifndef WIN32
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <CommonAPI/Config.hpp>
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/MainLoopContext.hpp>
+#include <CommonAPI/MemoryStream.hpp>
+#include <CommonAPI/ShmRingBuffer.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Watch calling a function whenever its file descriptor is readable.
+ */
+class ShmWatch : public Watch {
+public:
+    COMMONAPI_EXPORT ShmWatch(int _fd, std::function<void(unsigned int)> _callback);
+    COMMONAPI_EXPORT virtual ~ShmWatch();
+
+    COMMONAPI_EXPORT void dispatch(unsigned int _eventFlags);
+    COMMONAPI_EXPORT const pollfd &getAssociatedFileDescriptor();
+    COMMONAPI_EXPORT const std::vector<DispatchSource *> &getDependentDispatchSources();
+
+private:
+    pollfd pollFd_;
+    std::function<void(unsigned int)> callback_;
+    std::vector<DispatchSource *> dependentSources_;
+};
+
+/**
+ * \brief Bidirectional message channel between two processes.
+ *
+ * A channel consists of a ShmRingBuffer for each direction, an eventfd for
+ * each direction that signals new messages and one for each direction that
+ * signals that the receiver released messages. Messages are serialized
+ * directly into the shared memory of the receiver and deserialized from
+ * there, no further copies are made.
+ *
+ * One side creates the channel and passes the file descriptors returned by
+ * getPeerFileDescriptors() to the other side, which attaches to them.
+ */
+class ShmChannel : public std::enable_shared_from_this<ShmChannel> {
+public:
+    typedef std::function<void(MemoryOutputStream &)> MessageWriter;
+    typedef std::function<void(MemoryInputStream &)> MessageHandler;
+
+    static const std::size_t FILE_DESCRIPTORS = 6;
+
+    COMMONAPI_EXPORT static std::shared_ptr<ShmChannel> create(const std::string &_name,
+                                                               std::size_t _capacity);
+
+    /**
+     * \brief Attaches to a channel created by another process. Takes
+     *        ownership of the file descriptors and of the optional socket
+     *        the channel was received on, which is closed together with the
+     *        channel to let the other process notice the disconnect.
+     */
+    COMMONAPI_EXPORT static std::shared_ptr<ShmChannel> attach(const std::vector<int> &_fds,
+                                                               int _connection = -1);
+
+    COMMONAPI_EXPORT ~ShmChannel();
+
+    ShmChannel(const ShmChannel &) = delete;
+    ShmChannel &operator=(const ShmChannel &) = delete;
+
+    COMMONAPI_EXPORT std::vector<int> getPeerFileDescriptors() const;
+
+    /**
+     * \brief Sends a message. The writer serializes the message into the
+     *        shared memory. If the channel is full, waits for the receiver
+     *        to release messages up to the send timeout. Returns false if
+     *        the message did not fit meanwhile or exceeds the maximum
+     *        message size.
+     */
+    COMMONAPI_EXPORT bool send(const MessageWriter &_writer, std::size_t _size = 0);
+
+    /**
+     * \brief Sets how long send() waits for free space, in ms. -1 waits
+     *        forever, 0 does not wait. Defaults to DEFAULT_SEND_TIMEOUT_MS.
+     */
+    COMMONAPI_EXPORT void setSendTimeout(Timeout_t _timeout);
+
+    COMMONAPI_EXPORT void setMessageHandler(MessageHandler _handler);
+
+    /**
+     * \brief Processes all pending messages. Returns their number.
+     */
+    COMMONAPI_EXPORT std::size_t dispatch();
+
+    /**
+     * \brief Lets the given main loop context call dispatch() whenever
+     *        messages arrive. The watch is removed on destruction. The
+     *        channel is kept alive while the watch dispatches it, so a
+     *        message handler may release the last reference to it.
+     */
+    COMMONAPI_EXPORT void registerWatch(std::shared_ptr<MainLoopContext> _context,
+                                        DispatchPriority _priority = DispatchPriority::DEFAULT);
+
+private:
+    ShmChannel(std::shared_ptr<ShmRingBuffer> _outgoing, std::shared_ptr<ShmRingBuffer> _incoming,
+               int _notifyFd, int _waitFd, int _releaseNotifyFd, int _releaseWaitFd);
+
+    bool waitForRelease(Timeout_t _timeout,
+                        const std::chrono::steady_clock::time_point &_deadline);
+
+    std::shared_ptr<ShmRingBuffer> outgoing_;
+    std::shared_ptr<ShmRingBuffer> incoming_;
+    int notifyFd_;
+    int waitFd_;
+    int releaseNotifyFd_;
+    int releaseWaitFd_;
+    int connection_;
+    std::atomic<Timeout_t> sendTimeout_;
+
+    MessageHandler handler_;
+    std::mutex sendMutex_;
+    std::recursive_mutex dispatchMutex_;
+
+    std::shared_ptr<MainLoopContext> context_;
+    std::unique_ptr<ShmWatch> watch_;
+};
+
+} // namespace CommonAPI
+
+#endif // !WIN32
+
+#endif // COMMONAPI_SHMCHANNEL_HPP_
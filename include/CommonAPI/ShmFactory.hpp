@@ -0,0 +1,141 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_SHMFACTORY_HPP_
+#define COMMONAPI_SHMFACTORY_HPP_
+
+#ifndef WIN32
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <CommonAPI/Address.hpp>
+#include <CommonAPI/Export.hpp>
+#include <CommonAPI/Factory.hpp>
+#include <CommonAPI/ShmChannel.hpp>
+
+namespace CommonAPI {
+
+class ShmMainLoop;
+
+static const std::string SHM_BINDING = "shm";
+
+/**
+ * \brief Shared memory binding for processes on the same host.
+ *
+ * The factory is activated by registering it for SHM_BINDING:
+ *
+ *     Runtime::get()->registerFactory(SHM_BINDING, ShmFactory::get());
+ *
+ * Each registered stub listens on an abstract unix socket named after a
+ * hash of its address. A proxy connects to that socket and both sides
+ * exchange a hello with protocol version and full address, the proxy
+ * receives the file descriptors of a new ShmChannel together with the
+ * answer of the stub. The channel is used for all further communication
+ * between the two. Both sides only accept peers running as the same user
+ * or as root. Messages are serialized directly into the
+ * shared memory of the receiver, large payloads are not copied through a
+ * socket.
+ *
+ * As for the other bindings, the interface specific parts are provided by
+ * generated code: a proxy create function that builds a proxy on top of a
+ * channel, and a stub adapter create function that returns the handler for
+ * the requests a client sends. The channel owns the handler, which
+ * therefore only receives a weak reference to it. The handler is released
+ * when the client disconnects. Channels are dispatched by the given
+ * MainLoopContext, or by a thread of the factory if a connection id is used.
+ *
+ * Building a proxy blocks until the stub answered or the connect timeout
+ * passed, use Runtime::buildProxyAsync to avoid this.
+ */
+class ShmFactory : public Factory {
+public:
+    typedef std::function<std::shared_ptr<Proxy>(const Address &,
+                                                 const std::shared_ptr<ShmChannel> &)> ProxyCreateFunction;
+    typedef std::function<ShmChannel::MessageHandler(const Address &,
+                                                     const std::shared_ptr<StubBase> &,
+                                                     const std::weak_ptr<ShmChannel> &)> StubAdapterCreateFunction;
+
+    COMMONAPI_EXPORT static std::shared_ptr<ShmFactory> get();
+
+    COMMONAPI_EXPORT ShmFactory();
+    COMMONAPI_EXPORT virtual ~ShmFactory();
+
+    COMMONAPI_EXPORT void registerProxyCreateMethod(const std::string &_interface,
+                                                    ProxyCreateFunction _function);
+    COMMONAPI_EXPORT void registerStubAdapterCreateMethod(const std::string &_interface,
+                                                          StubAdapterCreateFunction _function);
+
+    /**
+     * \brief Sets the size of the shared memory buffer used for each
+     *        direction of a channel. Only affects new channels.
+     */
+    COMMONAPI_EXPORT void setChannelCapacity(std::size_t _capacity);
+
+    /**
+     * \brief Sets how long building a proxy waits for the stub to answer.
+     */
+    COMMONAPI_EXPORT void setConnectTimeout(std::chrono::milliseconds _timeout);
+
+    COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &_domain,
+                                                        const std::string &_interface,
+                                                        const std::string &_instance,
+                                                        const ConnectionId_t &_connectionId);
+
+    COMMONAPI_EXPORT std::shared_ptr<Proxy> createProxy(const std::string &_domain,
+                                                        const std::string &_interface,
+                                                        const std::string &_instance,
+                                                        std::shared_ptr<MainLoopContext> _context);
+
+    COMMONAPI_EXPORT bool registerStub(const std::string &_domain,
+                                       const std::string &_interface,
+                                       const std::string &_instance,
+                                       std::shared_ptr<StubBase> _stub,
+                                       const ConnectionId_t &_connectionId);
+
+    COMMONAPI_EXPORT bool registerStub(const std::string &_domain,
+                                       const std::string &_interface,
+                                       const std::string &_instance,
+                                       std::shared_ptr<StubBase> _stub,
+                                       std::shared_ptr<MainLoopContext> _context);
+
+    COMMONAPI_EXPORT bool unregisterStub(const std::string &_domain,
+                                         const std::string &_interface,
+                                         const std::string &_instance);
+
+private:
+    struct Service;
+
+    std::shared_ptr<Proxy> createShmProxy(const Address &_address,
+                                          std::shared_ptr<MainLoopContext> _context);
+    bool addService(const Address &_address,
+                    const std::shared_ptr<StubBase> &_stub,
+                    std::shared_ptr<MainLoopContext> _context);
+
+    std::shared_ptr<MainLoopContext> getDefaultContext();
+
+    std::map<std::string, ProxyCreateFunction> proxyCreateFunctions_;
+    std::map<std::string, StubAdapterCreateFunction> stubAdapterCreateFunctions_;
+    std::map<Address, std::shared_ptr<Service>> services_;
+    std::size_t channelCapacity_;
+    std::chrono::milliseconds connectTimeout_;
+
+    std::unique_ptr<ShmMainLoop> mainLoop_;
+    std::mutex mutex_;
+};
+
+} // namespace CommonAPI
+
+#endif // !WIN32
+
+#endif // COMMONAPI_SHMFACTORY_HPP_
@@ -0,0 +1,107 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#error "Only <CommonAPI/CommonAPI.hpp> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef COMMONAPI_SHMRINGBUFFER_HPP_
+#define COMMONAPI_SHMRINGBUFFER_HPP_
+
+#ifndef WIN32
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <CommonAPI/Export.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Single producer, single consumer message queue in shared memory.
+ *
+ * The buffer lives in an anonymous memory file (memfd) that can be mapped by
+ * another process by passing its file descriptor. Its size is sealed, so no
+ * process can truncate it while it is mapped. Messages are written and
+ * read in place: the writer reserves a contiguous region, serializes into it
+ * and commits it, the reader gets a pointer into the mapping and releases
+ * the message after it was processed. Messages never wrap around the end of
+ * the buffer, therefore the largest message is half the capacity.
+ *
+ * Reserve/commit must only be used by one thread at a time, the same holds
+ * for peek/release. Writer and reader do not need to synchronize.
+ */
+class ShmRingBuffer {
+public:
+    /**
+     * \brief Creates a new buffer. The capacity is rounded up to a power of
+     *        two. Returns an empty pointer if the memory file can't be created.
+     */
+    COMMONAPI_EXPORT static std::shared_ptr<ShmRingBuffer> create(const std::string &_name,
+                                                                  std::size_t _capacity);
+
+    /**
+     * \brief Maps a buffer created by another process. Takes ownership of
+     *        the file descriptor. The memory file must be sealed against
+     *        resizing, as done by create().
+     */
+    COMMONAPI_EXPORT static std::shared_ptr<ShmRingBuffer> attach(int _fd);
+
+    COMMONAPI_EXPORT ~ShmRingBuffer();
+
+    ShmRingBuffer(const ShmRingBuffer &) = delete;
+    ShmRingBuffer &operator=(const ShmRingBuffer &) = delete;
+
+    COMMONAPI_EXPORT int getFileDescriptor() const;
+    COMMONAPI_EXPORT std::size_t getCapacity() const;
+    COMMONAPI_EXPORT std::size_t getMaximumMessageSize() const;
+
+    /**
+     * \brief Reserves space for a message of at least the given size.
+     *
+     * Returns the payload area and sets _available to its size, which is
+     * the complete contiguous free space. Returns nullptr if there is not
+     * enough free space.
+     */
+    COMMONAPI_EXPORT uint8_t *reserve(std::size_t _size, std::size_t &_available);
+
+    /**
+     * \brief Publishes the reserved message with the given payload size.
+     */
+    COMMONAPI_EXPORT void commit(std::size_t _size);
+
+    /**
+     * \brief Returns the oldest message without removing it.
+     */
+    COMMONAPI_EXPORT bool peek(const uint8_t *&_data, std::size_t &_size);
+
+    /**
+     * \brief Removes the message returned by the last call to peek.
+     */
+    COMMONAPI_EXPORT void release();
+
+private:
+    struct Header;
+
+    ShmRingBuffer(int _fd, void *_memory, std::size_t _capacity);
+
+    static std::shared_ptr<ShmRingBuffer> map(int _fd);
+
+    int fd_;
+    Header *header_;
+    uint8_t *data_;
+    std::size_t capacity_;
+
+    uint64_t reserved_;
+    uint64_t peeked_;
+};
+
+} // namespace CommonAPI
+
+#endif // !WIN32
+
+#endif // COMMONAPI_SHMRINGBUFFER_HPP_
@@ -0,0 +1,100 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef COMMONAPI_STRINGVIEW_HPP_
+#define COMMONAPI_STRINGVIEW_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace CommonAPI {
+
+/**
+ * \brief Non-owning reference to a sequence of characters.
+ *
+ * Minimal replacement for std::string_view, which is not available in
+ * C++11. The referenced characters must outlive the view.
+ */
+class StringView {
+public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    StringView() : data_(""), size_(0) {}
+    StringView(const char *_data) : data_(_data), size_(std::strlen(_data)) {}
+    StringView(const char *_data, std::size_t _size) : data_(_data), size_(_size) {}
+    StringView(const std::string &_string) : data_(_string.data()), size_(_string.size()) {}
+
+    inline const char *data() const { return data_; }
+    inline std::size_t size() const { return size_; }
+    inline bool empty() const { return (0 == size_); }
+
+    inline const char *begin() const { return data_; }
+    inline const char *end() const { return data_ + size_; }
+
+    inline char operator[](std::size_t _index) const { return data_[_index]; }
+
+    inline std::size_t find(char _c, std::size_t _position = 0) const {
+        for (std::size_t i = _position; i < size_; i++) {
+            if (data_[i] == _c)
+                return i;
+        }
+        return npos;
+    }
+
+    inline StringView substr(std::size_t _position, std::size_t _count = npos) const {
+        if (_position > size_)
+            _position = size_;
+        return StringView(data_ + _position, std::min(_count, size_ - _position));
+    }
+
+    inline int compare(const StringView &_other) const {
+        int result = std::memcmp(data_, _other.data_, std::min(size_, _other.size_));
+        if (0 == result && size_ != _other.size_)
+            result = (size_ < _other.size_ ? -1 : 1);
+        return result;
+    }
+
+    inline std::string toString() const {
+        return std::string(data_, size_);
+    }
+
+    // FNV-1a
+    inline std::size_t hash() const {
+        uint64_t itsHash(14695981039346656037ULL);
+        for (std::size_t i = 0; i < size_; i++) {
+            itsHash ^= static_cast<unsigned char>(data_[i]);
+            itsHash *= 1099511628211ULL;
+        }
+        return static_cast<std::size_t>(itsHash);
+    }
+
+private:
+    const char *data_;
+    std::size_t size_;
+};
+
+inline bool operator==(const StringView &_lhs, const StringView &_rhs) {
+    return (_lhs.size() == _rhs.size() && 0 == _lhs.compare(_rhs));
+}
+
+inline bool operator!=(const StringView &_lhs, const StringView &_rhs) {
+    return !(_lhs == _rhs);
+}
+
+inline bool operator<(const StringView &_lhs, const StringView &_rhs) {
+    return (_lhs.compare(_rhs) < 0);
+}
+
+inline std::ostream &operator<<(std::ostream &_out, const StringView &_view) {
+    return _out.write(_view.data(), static_cast<std::streamsize>(_view.size()));
+}
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_STRINGVIEW_HPP_
@@ -10,11 +10,14 @@
 #ifndef COMMONAPI_STUB_HPP_
 #define COMMONAPI_STUB_HPP_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 
 #include <CommonAPI/Address.hpp>
+#include <CommonAPI/Executor.hpp>
+#include <CommonAPI/Export.hpp>
 #include <CommonAPI/Types.hpp>
 
 namespace CommonAPI {
@@ -30,7 +33,34 @@ protected:
 
 class StubBase {
 public:
-    virtual ~StubBase() {}
+    virtual ~StubBase() { setExecutor(nullptr); }
+
+    /**
+     * \brief Sets the executor for the calls received for this stub. The
+     *        executors are kept aside, so StubBase keeps its layout.
+     *
+     * The executor is removed by the destructor of StubBase. Stubs compiled
+     * against older headers do not remove it, use the overload taking the
+     * stub's shared pointer for them.
+     */
+    COMMONAPI_EXPORT void setExecutor(std::shared_ptr<Executor> _executor);
+
+    /**
+     * \brief Sets the executor for the calls received for this stub, which
+     *        is owned by _self. The executor is ignored once _self expired,
+     *        even if the stub did not remove it.
+     */
+    COMMONAPI_EXPORT void setExecutor(std::shared_ptr<Executor> _executor,
+                                      const std::weak_ptr<const StubBase> &_self);
+    COMMONAPI_EXPORT std::shared_ptr<Executor> getExecutor() const;
+
+    /**
+     * \brief Executes a call received for this stub. Without executor, the
+     *        call is executed directly by the calling thread. Returns false
+     *        if the executor rejected the call.
+     */
+    COMMONAPI_EXPORT bool execute(const std::shared_ptr<ClientId> &_client, std::size_t _method,
+                                  std::function<void()> _task);
 };
 
 template<typename StubAdapter_, typename StubRemoteEventHandler_>
@@ -0,0 +1,62 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef COMMONAPI_THREADPOOL_HPP_
+#define COMMONAPI_THREADPOOL_HPP_
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <CommonAPI/Export.hpp>
+
+namespace CommonAPI {
+
+/**
+ * \brief Fixed size pool of worker threads executing posted tasks.
+ *
+ * Tasks are executed in the order they were posted, by whichever worker
+ * becomes free first. On destruction, the pool finishes all queued tasks
+ * before joining its workers. The pool may be destroyed by one of its own
+ * tasks, that worker is then detached and exits once the queue is drained.
+ * To drop the queued tasks instead, call stop() before.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    COMMONAPI_EXPORT ThreadPool(std::size_t _threads);
+    COMMONAPI_EXPORT ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    COMMONAPI_EXPORT void post(Task _task);
+
+    /**
+     * \brief Drops all queued tasks and joins the workers.
+     *
+     * Waits for the tasks currently executed, except the calling one if called
+     * from a task. Tasks posted afterwards are dropped.
+     */
+    COMMONAPI_EXPORT void stop();
+
+    COMMONAPI_EXPORT std::size_t getThreadCount() const;
+
+private:
+    // Owned by the workers as well, to outlive the pool for a detached one
+    struct Queue;
+
+    static void run(std::shared_ptr<Queue> _queue);
+    void join();
+
+    std::shared_ptr<Queue> queue_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace CommonAPI
+
+#endif // COMMONAPI_THREADPOOL_HPP_
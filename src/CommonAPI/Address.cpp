@@ -3,13 +3,122 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 #include <CommonAPI/Address.hpp>
 
 namespace CommonAPI {
 
-Address::Address(const std::string &_address) {
+struct Address::Entry {
+    std::string address_;
+    std::string domain_;
+    std::string interface_;
+    std::string instance_;
+    std::size_t hash_;
+    // Only drops to zero, and is only raised from zero, while the lock of
+    // the shard is held
+    mutable std::atomic<std::size_t> references_;
+};
+
+namespace {
+
+struct StringViewHash {
+    std::size_t operator()(const StringView &_view) const {
+        return _view.hash();
+    }
+};
+
+} // namespace
+
+struct Address::Shard {
+    std::unordered_map<StringView, Entry *, StringViewHash> entries_;
+    std::mutex mutex_;
+};
+
+static const std::size_t ADDRESS_SHARDS(16);
+
+Address::Shard &
+Address::getShard(std::size_t _hash) {
+    // The shards are never destroyed, as addresses may be used by other
+    // static objects until the very end of the process.
+    static Shard *theShards = new Shard[ADDRESS_SHARDS];
+    return theShards[_hash % ADDRESS_SHARDS];
+}
+
+const Address::Entry *
+Address::intern(const StringView &_domain, const StringView &_interface, const StringView &_instance) {
+    // Reusing the buffer avoids allocations for known addresses
+    static thread_local std::string itsKey;
+    itsKey.clear();
+    itsKey.append(_domain.data(), _domain.size());
+    itsKey.push_back(':');
+    itsKey.append(_interface.data(), _interface.size());
+    itsKey.push_back(':');
+    itsKey.append(_instance.data(), _instance.size());
+
+    StringView itsView(itsKey);
+    std::size_t itsHash = itsView.hash();
+    Shard &itsShard = getShard(itsHash);
+
+    std::lock_guard<std::mutex> itsLock(itsShard.mutex_);
+    auto foundEntry = itsShard.entries_.find(itsView);
+    if (foundEntry != itsShard.entries_.end()) {
+        foundEntry->second->references_.fetch_add(1, std::memory_order_relaxed);
+        return foundEntry->second;
+    }
+
+    Entry *itsEntry = new Entry;
+    itsEntry->address_ = itsKey;
+    itsEntry->domain_ = _domain.toString();
+    itsEntry->interface_ = _interface.toString();
+    itsEntry->instance_ = _instance.toString();
+    itsEntry->hash_ = itsHash;
+    itsEntry->references_.store(1, std::memory_order_relaxed);
+
+    itsShard.entries_[StringView(itsEntry->address_)] = itsEntry;
+    return itsEntry;
+}
+
+void
+Address::acquire(const Entry *_entry) {
+    _entry->references_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+Address::release(const Entry *_entry) {
+    // No lock is needed as long as other references remain
+    std::size_t itsReferences = _entry->references_.load(std::memory_order_relaxed);
+    while (itsReferences > 1) {
+        if (_entry->references_.compare_exchange_weak(itsReferences, itsReferences - 1,
+                                                      std::memory_order_release,
+                                                      std::memory_order_relaxed))
+            return;
+    }
+
+    Shard &itsShard = getShard(_entry->hash_);
+    std::lock_guard<std::mutex> itsLock(itsShard.mutex_);
+    if (_entry->references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        itsShard.entries_.erase(StringView(_entry->address_));
+        delete _entry;
+    }
+}
+
+Address::Address()
+    : entry_(intern(StringView(), StringView(), StringView())) {
+}
+
+Address::Address(const char *_address)
+    : Address(StringView(_address)) {
+}
+
+Address::Address(const std::string &_address)
+    : Address(StringView(_address)) {
+}
+
+Address::Address(const StringView &_address)
+    : Address() {
     // TODO: handle error situation (_address is no valid CommonAPI address)
     setAddress(_address);
 }
@@ -17,105 +126,155 @@ Address::Address(const std::string &_address) {
 Address::Address(const std::string &_domain,
                  const std::string &_interface,
                  const std::string &_instance)
-    : domain_(_domain),
-      interface_(_interface),
-      instance_(_instance) {
+    : entry_(intern(_domain, _interface, _instance)) {
+}
+
+Address::Address(const StringView &_domain,
+                 const StringView &_interface,
+                 const StringView &_instance)
+    : entry_(intern(_domain, _interface, _instance)) {
 }
 
 Address::Address(const Address &_source)
-    : domain_(_source.domain_),
-      interface_(_source.interface_),
-      instance_(_source.instance_) {
+    : entry_(_source.entry_) {
+    acquire(entry_);
 }
 
 Address::~Address() {
+    release(entry_);
+}
+
+Address &
+Address::operator=(const Address &_source) {
+    acquire(_source.entry_);
+    release(entry_);
+    entry_ = _source.entry_;
+    return (*this);
 }
 
 bool
 Address::operator ==(const Address &_other) const {
-    return (domain_ == _other.domain_ &&
-            interface_ == _other.interface_ &&
-            instance_ == _other.instance_);
+    return (entry_ == _other.entry_);
 }
 
 bool
 Address::operator !=(const Address &_other) const {
-    return (domain_ != _other.domain_ ||
-            interface_ != _other.interface_ ||
-            instance_ != _other.instance_);
+    return (entry_ != _other.entry_);
 }
 
 bool
 Address::operator<(const Address &_other) const {
-    if (domain_ < _other.domain_)
-        return true;
-
-    if (domain_ == _other.domain_) {
-        if (interface_ < _other.interface_)
-            return true;
+    if (entry_ == _other.entry_)
+        return false;
 
-        if (interface_ == _other.interface_) {
-            if (instance_ < _other.instance_)
-                return true;
-        }
+    int itsResult = entry_->domain_.compare(_other.entry_->domain_);
+    if (itsResult == 0) {
+        itsResult = entry_->interface_.compare(_other.entry_->interface_);
+        if (itsResult == 0)
+            itsResult = entry_->instance_.compare(_other.entry_->instance_);
     }
-
-    return false;
+    return (itsResult < 0);
 }
 
 std::string
 Address::getAddress() const {
-    return (domain_ + ":" + interface_ + ":" + instance_);
+    return entry_->address_;
+}
+
+const std::string &
+Address::getAddressRef() const {
+    return entry_->address_;
 }
 
 void
 Address::setAddress(const std::string &_address) {
-    std::istringstream addressStream(_address);
-    if (std::getline(addressStream, domain_, ':')) {
-        if (std::getline(addressStream, interface_, ':')) {
-            if(!std::getline(addressStream, instance_, ':')) {
-                if(std::getline(addressStream, instance_)) {
-                }
+    setAddress(StringView(_address));
+}
+
+void
+Address::setAddress(const StringView &_address) {
+    // Missing parts keep their current value
+    StringView itsDomain(entry_->domain_);
+    StringView itsInterface(entry_->interface_);
+    StringView itsInstance(entry_->instance_);
+
+    if (_address.size() > 0) {
+        std::size_t itsFirst = _address.find(':');
+        itsDomain = _address.substr(0, itsFirst);
+        if (itsFirst != StringView::npos) {
+            std::size_t itsSecond = _address.find(':', itsFirst + 1);
+            itsInterface = _address.substr(itsFirst + 1, itsSecond - itsFirst - 1);
+            if (itsSecond != StringView::npos) {
+                std::size_t itsThird = _address.find(':', itsSecond + 1);
+                itsInstance = _address.substr(itsSecond + 1, itsThird - itsSecond - 1);
             }
         }
     }
+
+    const Entry *itsEntry = entry_;
+    entry_ = intern(itsDomain, itsInterface, itsInstance);
+    release(itsEntry);
 }
 
 const std::string &
 Address::getDomain() const {
-    return domain_;
+    return entry_->domain_;
 }
 
 void
 Address::setDomain(const std::string &_domain) {
-    domain_ = _domain;
+    setDomain(StringView(_domain));
+}
+
+void
+Address::setDomain(const StringView &_domain) {
+    const Entry *itsEntry = entry_;
+    entry_ = intern(_domain, entry_->interface_, entry_->instance_);
+    release(itsEntry);
 }
 
 const std::string &
 Address::getInterface() const {
-    return interface_;
+    return entry_->interface_;
 }
 
 void
 Address::setInterface(const std::string &_interface) {
-    interface_ = _interface;
+    setInterface(StringView(_interface));
+}
+
+void
+Address::setInterface(const StringView &_interface) {
+    const Entry *itsEntry = entry_;
+    entry_ = intern(entry_->domain_, _interface, entry_->instance_);
+    release(itsEntry);
 }
 
 const std::string &
 Address::getInstance() const {
-    return instance_;
+    return entry_->instance_;
 }
 
 void
 Address::setInstance(const std::string &_instance) {
-    instance_ = _instance;
+    setInstance(StringView(_instance));
+}
+
+void
+Address::setInstance(const StringView &_instance) {
+    const Entry *itsEntry = entry_;
+    entry_ = intern(entry_->domain_, entry_->interface_, _instance);
+    release(itsEntry);
+}
+
+std::size_t
+Address::getHash() const {
+    return entry_->hash_;
 }
 
 std::ostream &
 operator<<(std::ostream &_out, const Address &_address) {
-    _out << _address.domain_
-          << ":" << _address.interface_
-          << ":" << _address.instance_;
+    _out << _address.entry_->address_;
     return _out;
 }
 
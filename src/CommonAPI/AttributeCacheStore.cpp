@@ -0,0 +1,229 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <CommonAPI/AttributeCacheStore.hpp>
+#include <CommonAPI/Deployment.hpp>
+#include <CommonAPI/Logger.hpp>
+#include <CommonAPI/MemoryStream.hpp>
+
+namespace CommonAPI {
+
+static const uint32_t STORE_MAGIC = 0x43414353; // "CACS"
+static const uint32_t STORE_VERSION = 1;
+
+#ifndef WIN32
+static bool
+writeAll(int _fd, const void *_data, std::size_t _size) {
+    const char *itsData = static_cast<const char *>(_data);
+    while (_size > 0) {
+        ssize_t itsWritten = ::write(_fd, itsData, _size);
+        if (itsWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        itsData += itsWritten;
+        _size -= std::size_t(itsWritten);
+    }
+    return true;
+}
+#endif
+
+std::shared_ptr<AttributeCacheStore>
+AttributeCacheStore::open(const std::string &_path) {
+    std::shared_ptr<AttributeCacheStore> itsStore(new AttributeCacheStore(_path));
+    itsStore->load();
+    return itsStore;
+}
+
+AttributeCacheStore::AttributeCacheStore(const std::string &_path)
+    : path_(_path), nextSourceId_(1) {
+}
+
+AttributeCacheStore::~AttributeCacheStore() {
+    (void)save();
+}
+
+bool
+AttributeCacheStore::get(const std::string &_key, ByteBuffer &_value) const {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    auto itsValue = values_.find(_key);
+    if (itsValue == values_.end())
+        return false;
+    _value = itsValue->second;
+    return true;
+}
+
+void
+AttributeCacheStore::put(const std::string &_key, const ByteBuffer &_value) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    values_[_key] = _value;
+}
+
+AttributeCacheStore::SourceId
+AttributeCacheStore::attach(const std::string &_key, Source _source) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    SourceId itsId = nextSourceId_++;
+    sources_[itsId] = std::make_pair(_key, std::move(_source));
+    return itsId;
+}
+
+void
+AttributeCacheStore::detach(SourceId _source) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    auto itsSource = sources_.find(_source);
+    if (itsSource != sources_.end()) {
+        // A later source of the key overwrites the value on the next save
+        ByteBuffer itsValue;
+        if (itsSource->second.second(itsValue))
+            values_[itsSource->second.first] = std::move(itsValue);
+        sources_.erase(itsSource);
+    }
+}
+
+bool
+AttributeCacheStore::save() {
+    // Saves are serialized, the file must reflect the values of the last one
+    std::lock_guard<std::mutex> itsSaveLock(saveMutex_);
+
+    ByteBuffer itsBuffer;
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        collect();
+
+        MemoryOutputStream itsStream(itsBuffer);
+        itsStream.writeValue<EmptyDeployment>(STORE_MAGIC);
+        itsStream.writeValue<EmptyDeployment>(STORE_VERSION);
+        itsStream.writeValue<EmptyDeployment>(values_);
+        if (itsStream.hasError()) {
+            COMMONAPI_ERROR("Cannot serialize attribute cache \'", path_, "\'");
+            return false;
+        }
+    }
+
+#ifdef WIN32
+    std::string itsTemporary(path_ + ".tmp");
+    {
+        std::ofstream itsFile(itsTemporary, std::ofstream::binary | std::ofstream::trunc);
+        itsFile.write(reinterpret_cast<const char *>(itsBuffer.data()), std::streamsize(itsBuffer.size()));
+        if (!itsFile) {
+            COMMONAPI_ERROR("Cannot write attribute cache \'", itsTemporary, "\'");
+            itsFile.close();
+            (void)std::remove(itsTemporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(itsTemporary.c_str(), path_.c_str()) != 0) {
+        COMMONAPI_ERROR("Cannot write attribute cache \'", path_, "\' (", errno, ")");
+        (void)std::remove(itsTemporary.c_str());
+        return false;
+    }
+#else
+    // Write to a temporary file of our own and make it durable before it
+    // replaces the store, which is therefore never seen partially written,
+    // also not after a crash. Other processes saving the same store each
+    // rename a complete file, the last one wins.
+    std::vector<char> itsTemporary(path_.begin(), path_.end());
+    const char itsSuffix[] = ".XXXXXX";
+    itsTemporary.insert(itsTemporary.end(), itsSuffix, itsSuffix + sizeof(itsSuffix));
+    int itsFd = mkostemp(&itsTemporary[0], O_CLOEXEC);
+    if (itsFd < 0) {
+        COMMONAPI_ERROR("Cannot write attribute cache \'", path_, "\' (", errno, ")");
+        return false;
+    }
+
+    bool isWritten = (writeAll(itsFd, itsBuffer.data(), itsBuffer.size())
+            && fchmod(itsFd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0
+            && fsync(itsFd) == 0);
+    isWritten = (close(itsFd) == 0 && isWritten);
+    if (!isWritten || std::rename(&itsTemporary[0], path_.c_str()) != 0) {
+        COMMONAPI_ERROR("Cannot write attribute cache \'", path_, "\' (", errno, ")");
+        (void)std::remove(&itsTemporary[0]);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void
+AttributeCacheStore::load() {
+    const uint8_t *itsData(nullptr);
+    std::size_t itsSize(0);
+
+#ifdef WIN32
+    std::ifstream itsFile(path_, std::ifstream::binary);
+    if (!itsFile.is_open())
+        return;
+    ByteBuffer itsContent((std::istreambuf_iterator<char>(itsFile)), std::istreambuf_iterator<char>());
+    itsData = itsContent.data();
+    itsSize = itsContent.size();
+#else
+    int itsFd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (itsFd < 0)
+        return;
+
+    struct stat itsStatus;
+    if (fstat(itsFd, &itsStatus) != 0 || itsStatus.st_size == 0) {
+        close(itsFd);
+        return;
+    }
+
+    itsSize = static_cast<std::size_t>(itsStatus.st_size);
+    void *itsMemory = mmap(nullptr, itsSize, PROT_READ, MAP_PRIVATE, itsFd, 0);
+    close(itsFd);
+    if (MAP_FAILED == itsMemory)
+        return;
+    itsData = static_cast<const uint8_t *>(itsMemory);
+#endif
+
+    uint32_t itsMagic(0), itsVersion(0);
+    std::unordered_map<std::string, ByteBuffer> itsValues;
+
+    MemoryInputStream itsStream(itsData, itsSize);
+    itsStream.readValue<EmptyDeployment>(itsMagic);
+    itsStream.readValue<EmptyDeployment>(itsVersion);
+    if (!itsStream.hasError() && itsMagic == STORE_MAGIC && itsVersion == STORE_VERSION)
+        itsStream.readValue<EmptyDeployment>(itsValues);
+
+#ifndef WIN32
+    munmap(const_cast<uint8_t *>(itsData), itsSize);
+#endif
+
+    if (itsStream.hasError() || itsMagic != STORE_MAGIC || itsVersion != STORE_VERSION) {
+        COMMONAPI_WARNING("Ignoring invalid attribute cache \'", path_, "\'");
+        return;
+    }
+
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    values_ = std::move(itsValues);
+    COMMONAPI_DEBUG("Loaded attribute cache \'", path_, "\' (", values_.size(), " values)");
+}
+
+// Takes the current values of all attached sources
+void
+AttributeCacheStore::collect() {
+    for (auto &source : sources_) {
+        ByteBuffer itsValue;
+        if (source.second.second(itsValue))
+            values_[source.second.first] = std::move(itsValue);
+    }
+}
+
+} // namespace CommonAPI
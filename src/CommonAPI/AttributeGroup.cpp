@@ -0,0 +1,119 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <atomic>
+
+#include <CommonAPI/AttributeGroup.hpp>
+
+namespace CommonAPI {
+
+// State of a single send. Each request writes its own status, the request
+// completing last reads all of them and fulfills the promise.
+struct AttributeGroup::Completion {
+    Completion(std::size_t _size)
+        : remaining_(_size), statuses_(_size, CallStatus::UNKNOWN) {
+    }
+
+    std::atomic<std::size_t> remaining_;
+    std::vector<CallStatus> statuses_;
+    Promise<CallStatus> promise_;
+};
+
+AttributeGroup::AttributeGroup(std::shared_ptr<AttributeBatch> _batch)
+    : batch_(_batch) {
+}
+
+AttributeGroup::AttributeGroup(Proxy &_proxy) {
+    AttributeBatchSupport *itsSupport = dynamic_cast<AttributeBatchSupport *>(&_proxy);
+    if (itsSupport)
+        batch_ = itsSupport->createAttributeBatch();
+}
+
+AttributeGroup::~AttributeGroup() {
+}
+
+std::size_t
+AttributeGroup::add(std::shared_ptr<AttributeRequest> _request) {
+    requests_.push_back(_request);
+    return (requests_.size() - 1);
+}
+
+std::size_t
+AttributeGroup::size() const {
+    return requests_.size();
+}
+
+Future<CallStatus>
+AttributeGroup::send(const CallInfo *_info) {
+    std::shared_ptr<Completion> itsCompletion = std::make_shared<Completion>(requests_.size());
+    Future<CallStatus> itsFuture = itsCompletion->promise_.getFuture();
+    completion_ = itsCompletion;
+
+    if (requests_.empty()) {
+        itsCompletion->promise_.setValue(CallStatus::SUCCESS);
+        return itsFuture;
+    }
+
+    for (std::size_t i = 0; i < requests_.size(); i++) {
+        requests_[i]->completion_ = itsCompletion;
+        requests_[i]->index_ = i;
+    }
+
+    // Requests the batch does not take are issued separately
+    std::vector<std::shared_ptr<AttributeRequest>> itsSeparate;
+    if (batch_) {
+        for (auto &request : requests_) {
+            if (!batch_->add(request))
+                itsSeparate.push_back(request);
+        }
+        if (itsSeparate.size() < requests_.size())
+            batch_->send(_info);
+    } else {
+        itsSeparate = requests_;
+    }
+
+    for (auto &request : itsSeparate)
+        request->send(_info);
+
+    return itsFuture;
+}
+
+CallStatus
+AttributeGroup::getCallStatus(std::size_t _index) const {
+    if (!completion_
+            || completion_->remaining_.load(std::memory_order_acquire) > 0
+            || _index >= completion_->statuses_.size())
+        return CallStatus::UNKNOWN;
+    return completion_->statuses_[_index];
+}
+
+AttributeRequest::AttributeRequest(bool _isSet)
+    : isSet_(_isSet), index_(0) {
+}
+
+AttributeRequest::~AttributeRequest() {
+}
+
+void
+AttributeRequest::complete(const CallStatus &_status) {
+    std::shared_ptr<AttributeGroup::Completion> itsCompletion;
+    itsCompletion.swap(completion_);
+    if (!itsCompletion)
+        return;
+
+    itsCompletion->statuses_[index_] = _status;
+    if (itsCompletion->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        CallStatus itsStatus(CallStatus::SUCCESS);
+        for (auto status : itsCompletion->statuses_) {
+            if (status != CallStatus::SUCCESS) {
+                itsStatus = status;
+                break;
+            }
+        }
+        itsCompletion->promise_.setValue(itsStatus);
+    }
+}
+
+} // namespace CommonAPI
@@ -0,0 +1,446 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <CommonAPI/ConfigurationCache.hpp>
+#include <CommonAPI/Logger.hpp>
+
+namespace CommonAPI {
+
+static const uint32_t CACHE_MAGIC = 0x43414343; // "CACC"
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t CACHE_NO_ENTRY = 0xFFFFFFFF;
+static const uint32_t CACHE_MAXIMUM_SEED = 0x1000000;
+
+/*
+ * Layout: header, sections sorted by name, entries sorted by section and
+ * key, the seeds of the perfect hash per bucket, the entry index per hash
+ * slot and finally all strings.
+ */
+struct ConfigurationCache::Header {
+    uint32_t magic_;
+    uint32_t version_;
+    uint64_t sourceSize_;
+    int64_t sourceSeconds_;
+    int64_t sourceNanoseconds_;
+    uint32_t sections_;
+    uint32_t entries_;
+    uint32_t buckets_;
+    uint32_t strings_;
+};
+
+struct ConfigurationCache::Section {
+    uint32_t name_;
+    uint32_t nameSize_;
+    uint32_t first_;
+    uint32_t count_;
+};
+
+struct ConfigurationCache::Entry {
+    uint32_t section_;
+    uint32_t key_;
+    uint32_t keySize_;
+    uint32_t value_;
+    uint32_t valueSize_;
+};
+
+/*
+ * Hash and displace: each key is assigned to a bucket by its hash. The
+ * seed of the bucket is chosen such that the keys of all buckets end up
+ * in different slots.
+ */
+static uint64_t
+getBaseHash(const StringView &_section, const StringView &_key) {
+    uint64_t itsHash(14695981039346656037ULL);
+    for (std::size_t i = 0; i < _section.size(); i++) {
+        itsHash ^= static_cast<unsigned char>(_section[i]);
+        itsHash *= 1099511628211ULL;
+    }
+    itsHash *= 1099511628211ULL; // separator
+    for (std::size_t i = 0; i < _key.size(); i++) {
+        itsHash ^= static_cast<unsigned char>(_key[i]);
+        itsHash *= 1099511628211ULL;
+    }
+    return itsHash;
+}
+
+static uint64_t
+getSeededHash(uint64_t _hash, uint32_t _seed) {
+    uint64_t itsHash = _hash ^ (uint64_t(_seed) * 0x9E3779B97F4A7C15ULL);
+    itsHash = (itsHash ^ (itsHash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    itsHash = (itsHash ^ (itsHash >> 27)) * 0x94D049BB133111EBULL;
+    return (itsHash ^ (itsHash >> 31));
+}
+
+static bool
+getSourceStatus(const std::string &_source, struct stat &_status) {
+    return (stat(_source.c_str(), &_status) == 0);
+}
+
+static int64_t
+getSourceNanoseconds(const struct stat &_status) {
+#ifdef WIN32
+    (void)_status;
+    return 0;
+#else
+    return int64_t(_status.st_mtim.tv_nsec);
+#endif
+}
+
+#ifndef WIN32
+static bool
+writeAll(int _fd, const void *_data, std::size_t _size) {
+    const char *itsData = static_cast<const char *>(_data);
+    while (_size > 0) {
+        ssize_t itsWritten = ::write(_fd, itsData, _size);
+        if (itsWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        itsData += itsWritten;
+        _size -= std::size_t(itsWritten);
+    }
+    return true;
+}
+#endif
+
+std::shared_ptr<const ConfigurationCache>
+ConfigurationCache::open(const std::string &_path, const std::string &_source) {
+    std::shared_ptr<const ConfigurationCache> itsCache = map(_path, _source);
+    if (itsCache)
+        return itsCache;
+
+    // The status is taken while reading, a change afterwards must outdate
+    // the cache
+    IniFileReader itsReader;
+    IniFileReader::FileStatus itsStatus;
+    if (!itsReader.scan(_source, itsStatus) || !write(_path, itsStatus, itsReader))
+        return nullptr;
+
+    return map(_path, _source);
+}
+
+bool
+ConfigurationCache::write(const std::string &_path, const IniFileReader::FileStatus &_source,
+                          const IniFileReader &_reader) {
+#ifdef WIN32
+    // Caches are never mapped on Windows
+    (void)_path;
+    (void)_source;
+    (void)_reader;
+    return false;
+#else
+    if (!_source.isValid_) {
+        COMMONAPI_DEBUG("Not writing configuration cache \'", _path,
+                        "\', source missing or changed while read");
+        return false;
+    }
+
+    std::vector<Section> itsSections;
+    std::vector<Entry> itsEntries;
+    std::vector<uint64_t> itsHashes;
+    std::string itsStrings;
+
+    auto addString = [&itsStrings](const StringView &_string) {
+        uint32_t itsOffset = uint32_t(itsStrings.size());
+        itsStrings.append(_string.data(), _string.size());
+        return itsOffset;
+    };
+
+    // Sections and keys are kept sorted by IniFileReader already
+    for (auto &s : _reader.getSectionNames()) {
+        Section itsSection;
+        itsSection.name_ = addString(s);
+        itsSection.nameSize_ = uint32_t(s.size());
+        itsSection.first_ = uint32_t(itsEntries.size());
+
+        _reader.forEach(s, [&](const StringView &_key, const StringView &_value) {
+            Entry itsEntry;
+            itsEntry.section_ = uint32_t(itsSections.size());
+            itsEntry.key_ = addString(_key);
+            itsEntry.keySize_ = uint32_t(_key.size());
+            itsEntry.value_ = addString(_value);
+            itsEntry.valueSize_ = uint32_t(_value.size());
+            itsEntries.push_back(itsEntry);
+            itsHashes.push_back(getBaseHash(s, _key));
+        });
+        itsSection.count_ = uint32_t(itsEntries.size()) - itsSection.first_;
+        itsSections.push_back(itsSection);
+    }
+
+    // Build the perfect hash, starting with the largest buckets
+    const uint32_t itsCount = uint32_t(itsEntries.size());
+    const uint32_t itsBucketCount = std::max(uint32_t(1), itsCount / 4);
+    std::vector<std::vector<uint32_t>> itsBuckets(itsBucketCount);
+    for (uint32_t i = 0; i < itsCount; i++)
+        itsBuckets[getSeededHash(itsHashes[i], 0) % itsBucketCount].push_back(i);
+
+    std::vector<uint32_t> itsOrder(itsBucketCount);
+    for (uint32_t i = 0; i < itsBucketCount; i++)
+        itsOrder[i] = i;
+    std::stable_sort(itsOrder.begin(), itsOrder.end(), [&itsBuckets](uint32_t _a, uint32_t _b) {
+        return (itsBuckets[_a].size() > itsBuckets[_b].size());
+    });
+
+    std::vector<uint32_t> itsSeeds(itsBucketCount, 0);
+    std::vector<uint32_t> itsSlots(itsCount, CACHE_NO_ENTRY);
+    std::vector<uint32_t> itsCandidates;
+    for (auto b : itsOrder) {
+        const std::vector<uint32_t> &itsBucket = itsBuckets[b];
+        if (itsBucket.empty())
+            break;
+
+        uint32_t itsSeed(1);
+        for (; itsSeed < CACHE_MAXIMUM_SEED; itsSeed++) {
+            itsCandidates.clear();
+            bool isFree(true);
+            for (auto e : itsBucket) {
+                uint32_t itsSlot = uint32_t(getSeededHash(itsHashes[e], itsSeed) % itsCount);
+                if (itsSlots[itsSlot] != CACHE_NO_ENTRY
+                        || std::find(itsCandidates.begin(), itsCandidates.end(), itsSlot) != itsCandidates.end()) {
+                    isFree = false;
+                    break;
+                }
+                itsCandidates.push_back(itsSlot);
+            }
+            if (isFree)
+                break;
+        }
+        if (itsSeed == CACHE_MAXIMUM_SEED) {
+            COMMONAPI_ERROR("Cannot build index for configuration cache \'", _path, "\'");
+            return false;
+        }
+
+        itsSeeds[b] = itsSeed;
+        for (std::size_t i = 0; i < itsBucket.size(); i++)
+            itsSlots[itsCandidates[i]] = itsBucket[i];
+    }
+
+    Header itsHeader;
+    std::memset(&itsHeader, 0, sizeof(itsHeader));
+    itsHeader.magic_ = CACHE_MAGIC;
+    itsHeader.version_ = CACHE_VERSION;
+    itsHeader.sourceSize_ = _source.size_;
+    itsHeader.sourceSeconds_ = _source.seconds_;
+    itsHeader.sourceNanoseconds_ = _source.nanoseconds_;
+    itsHeader.sections_ = uint32_t(itsSections.size());
+    itsHeader.entries_ = itsCount;
+    itsHeader.buckets_ = itsBucketCount;
+    itsHeader.strings_ = uint32_t(itsStrings.size());
+
+    // Write to a temporary file of our own first, readers must never see a
+    // partial cache and a mapped cache must never be truncated. Concurrent
+    // writers each rename a complete file, the last one wins.
+    std::vector<char> itsTemporary(_path.begin(), _path.end());
+    const char itsSuffix[] = ".XXXXXX";
+    itsTemporary.insert(itsTemporary.end(), itsSuffix, itsSuffix + sizeof(itsSuffix));
+    int itsFd = mkostemp(&itsTemporary[0], O_CLOEXEC);
+    if (itsFd < 0) {
+        COMMONAPI_ERROR("Cannot write configuration cache \'", _path, "\' (", errno, ")");
+        return false;
+    }
+
+    bool isWritten = (writeAll(itsFd, &itsHeader, sizeof(itsHeader))
+            && writeAll(itsFd, itsSections.data(), itsSections.size() * sizeof(Section))
+            && writeAll(itsFd, itsEntries.data(), itsEntries.size() * sizeof(Entry))
+            && writeAll(itsFd, itsSeeds.data(), itsSeeds.size() * sizeof(uint32_t))
+            && writeAll(itsFd, itsSlots.data(), itsSlots.size() * sizeof(uint32_t))
+            && writeAll(itsFd, itsStrings.data(), itsStrings.size())
+            && fchmod(itsFd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0
+            && fsync(itsFd) == 0);
+    isWritten = (close(itsFd) == 0 && isWritten);
+    if (!isWritten || std::rename(&itsTemporary[0], _path.c_str()) != 0) {
+        COMMONAPI_ERROR("Cannot write configuration cache \'", _path, "\' (", errno, ")");
+        (void)std::remove(&itsTemporary[0]);
+        return false;
+    }
+
+    COMMONAPI_DEBUG("Wrote configuration cache \'", _path, "\' (", itsCount, " entries)");
+    return true;
+#endif
+}
+
+std::shared_ptr<const ConfigurationCache>
+ConfigurationCache::map(const std::string &_path, const std::string &_source) {
+#ifdef WIN32
+    (void)_path;
+    (void)_source;
+    return nullptr;
+#else
+    struct stat itsSourceStatus;
+    if (!getSourceStatus(_source, itsSourceStatus))
+        return nullptr;
+
+    int itsFd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (itsFd < 0)
+        return nullptr;
+
+    struct stat itsStatus;
+    if (fstat(itsFd, &itsStatus) != 0 || std::size_t(itsStatus.st_size) < sizeof(Header)) {
+        close(itsFd);
+        return nullptr;
+    }
+
+    std::size_t itsSize(static_cast<std::size_t>(itsStatus.st_size));
+    void *itsMemory = mmap(nullptr, itsSize, PROT_READ, MAP_PRIVATE, itsFd, 0);
+    close(itsFd);
+    if (MAP_FAILED == itsMemory)
+        return nullptr;
+
+    // The header is checked before the constructor computes the positions
+    // of the tables from it.
+    const Header *itsHeader = static_cast<const Header *>(itsMemory);
+    if (itsHeader->magic_ != CACHE_MAGIC
+            || itsHeader->version_ != CACHE_VERSION
+            || itsHeader->buckets_ == 0
+            || sizeof(Header)
+               + uint64_t(itsHeader->sections_) * sizeof(Section)
+               + uint64_t(itsHeader->entries_) * sizeof(Entry)
+               + uint64_t(itsHeader->buckets_) * sizeof(uint32_t)
+               + uint64_t(itsHeader->entries_) * sizeof(uint32_t)
+               + uint64_t(itsHeader->strings_) != uint64_t(itsSize)) {
+        munmap(itsMemory, itsSize);
+        COMMONAPI_WARNING("Ignoring invalid configuration cache \'", _path, "\'");
+        return nullptr;
+    }
+
+    std::shared_ptr<const ConfigurationCache> itsCache(new ConfigurationCache(itsMemory, itsSize));
+    if (!itsCache->isValid()) {
+        COMMONAPI_WARNING("Ignoring invalid configuration cache \'", _path, "\'");
+        return nullptr;
+    }
+
+    if (itsHeader->sourceSize_ != uint64_t(itsSourceStatus.st_size)
+            || itsHeader->sourceSeconds_ != int64_t(itsSourceStatus.st_mtime)
+            || itsHeader->sourceNanoseconds_ != getSourceNanoseconds(itsSourceStatus)) {
+        COMMONAPI_DEBUG("Configuration cache \'", _path, "\' is outdated");
+        return nullptr;
+    }
+
+    COMMONAPI_DEBUG("Using configuration cache \'", _path, "\'");
+    return itsCache;
+#endif
+}
+
+ConfigurationCache::ConfigurationCache(const void *_memory, std::size_t _size)
+    : memory_(_memory), size_(_size) {
+    const char *itsPosition = static_cast<const char *>(memory_);
+    header_ = reinterpret_cast<const Header *>(itsPosition);
+    itsPosition += sizeof(Header);
+    sections_ = reinterpret_cast<const Section *>(itsPosition);
+    itsPosition += header_->sections_ * sizeof(Section);
+    entries_ = reinterpret_cast<const Entry *>(itsPosition);
+    itsPosition += header_->entries_ * sizeof(Entry);
+    seeds_ = reinterpret_cast<const uint32_t *>(itsPosition);
+    itsPosition += header_->buckets_ * sizeof(uint32_t);
+    slots_ = reinterpret_cast<const uint32_t *>(itsPosition);
+    itsPosition += header_->entries_ * sizeof(uint32_t);
+    strings_ = itsPosition;
+}
+
+bool
+ConfigurationCache::isValid() const {
+    // All offsets and counts are checked once, lookups rely on them
+    for (uint32_t i = 0; i < header_->sections_; i++) {
+        const Section &itsSection = sections_[i];
+        if (uint64_t(itsSection.name_) + itsSection.nameSize_ > header_->strings_
+                || uint64_t(itsSection.first_) + itsSection.count_ > header_->entries_)
+            return false;
+    }
+    for (uint32_t i = 0; i < header_->entries_; i++) {
+        const Entry &itsEntry = entries_[i];
+        if (itsEntry.section_ >= header_->sections_
+                || uint64_t(itsEntry.key_) + itsEntry.keySize_ > header_->strings_
+                || uint64_t(itsEntry.value_) + itsEntry.valueSize_ > header_->strings_)
+            return false;
+        if (slots_[i] != CACHE_NO_ENTRY && slots_[i] >= header_->entries_)
+            return false;
+    }
+    return true;
+}
+
+ConfigurationCache::~ConfigurationCache() {
+#ifndef WIN32
+    munmap(const_cast<void *>(memory_), size_);
+#endif
+}
+
+bool
+ConfigurationCache::hasSection(const StringView &_section) const {
+    return (nullptr != findSection(_section));
+}
+
+bool
+ConfigurationCache::find(const StringView &_section, const StringView &_key, StringView &_value) const {
+    if (0 == header_->entries_)
+        return false;
+
+    uint64_t itsHash = getBaseHash(_section, _key);
+    uint32_t itsSeed = seeds_[getSeededHash(itsHash, 0) % header_->buckets_];
+    uint32_t itsIndex = slots_[getSeededHash(itsHash, itsSeed) % header_->entries_];
+    if (itsIndex >= header_->entries_)
+        return false;
+
+    // Keys that are not contained hash to an arbitrary entry
+    const Entry &itsEntry = entries_[itsIndex];
+    if (itsEntry.section_ >= header_->sections_)
+        return false;
+
+    const Section &itsSection = sections_[itsEntry.section_];
+    if (getString(itsEntry.key_, itsEntry.keySize_) != _key
+            || getString(itsSection.name_, itsSection.nameSize_) != _section)
+        return false;
+
+    _value = getString(itsEntry.value_, itsEntry.valueSize_);
+    return true;
+}
+
+void
+ConfigurationCache::forEach(const StringView &_section, const MappingHandler &_handler) const {
+    const Section *itsSection = findSection(_section);
+    if (!itsSection)
+        return;
+
+    for (uint32_t i = itsSection->first_; i < itsSection->first_ + itsSection->count_; i++) {
+        const Entry &itsEntry = entries_[i];
+        _handler(getString(itsEntry.key_, itsEntry.keySize_),
+                 getString(itsEntry.value_, itsEntry.valueSize_));
+    }
+}
+
+const ConfigurationCache::Section *
+ConfigurationCache::findSection(const StringView &_section) const {
+    const Section *itsEnd = sections_ + header_->sections_;
+    const Section *itsSection = std::lower_bound(sections_, itsEnd, _section,
+        [this](const Section &_candidate, const StringView &_name) {
+            return (getString(_candidate.name_, _candidate.nameSize_) < _name);
+        });
+    if (itsSection != itsEnd && getString(itsSection->name_, itsSection->nameSize_) == _section)
+        return itsSection;
+    return nullptr;
+}
+
+StringView
+ConfigurationCache::getString(uint32_t _offset, uint32_t _size) const {
+    if (uint64_t(_offset) + _size > header_->strings_)
+        return StringView();
+    return StringView(strings_ + _offset, _size);
+}
+
+} // namespace CommonAPI
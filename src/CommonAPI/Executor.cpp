@@ -0,0 +1,125 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <CommonAPI/Executor.hpp>
+#include <CommonAPI/ThreadPool.hpp>
+
+namespace CommonAPI {
+
+const std::size_t ThreadPoolExecutor::UNLIMITED;
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t _threads,
+                                       Ordering _ordering, std::size_t _maxQueueSize)
+    : pool_(std::make_shared<ThreadPool>(_threads)),
+      ordering_(_ordering),
+      maxQueueSize_(_maxQueueSize),
+      queued_(0),
+      pending_(0) {
+}
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::shared_ptr<ThreadPool> _pool,
+                                       Ordering _ordering, std::size_t _maxQueueSize)
+    : pool_(_pool),
+      ordering_(_ordering),
+      maxQueueSize_(_maxQueueSize),
+      queued_(0),
+      pending_(0) {
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    std::unique_lock<std::mutex> itsLock(mutex_);
+    finished_.wait(itsLock, [this]() { return (0 == pending_); });
+}
+
+bool
+ThreadPoolExecutor::execute(const std::shared_ptr<ClientId> &_client,
+                            std::size_t _method, Task _task) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    if (maxQueueSize_ != UNLIMITED && queued_ >= maxQueueSize_)
+        return false;
+
+    queued_++;
+    pending_++;
+
+    std::shared_ptr<Strand> itsStrand;
+    if (ordering_ == Ordering::PER_CLIENT && _client) {
+        auto foundStrand = clientStrands_.find(_client);
+        if (foundStrand != clientStrands_.end()) {
+            foundStrand->second->tasks_.push_back(std::move(_task));
+            return true;
+        }
+        itsStrand = std::make_shared<Strand>();
+        itsStrand->client_ = _client;
+        clientStrands_[_client] = itsStrand;
+    } else if (ordering_ == Ordering::PER_METHOD) {
+        auto foundStrand = methodStrands_.find(_method);
+        if (foundStrand != methodStrands_.end()) {
+            foundStrand->second->tasks_.push_back(std::move(_task));
+            return true;
+        }
+        itsStrand = std::make_shared<Strand>();
+        itsStrand->method_ = _method;
+        methodStrands_[_method] = itsStrand;
+    }
+
+    post(itsStrand, std::move(_task));
+    return true;
+}
+
+ThreadPoolExecutor::Ordering
+ThreadPoolExecutor::getOrdering() const {
+    return ordering_;
+}
+
+std::size_t
+ThreadPoolExecutor::getMaxQueueSize() const {
+    return maxQueueSize_;
+}
+
+std::size_t
+ThreadPoolExecutor::getQueueSize() const {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    return queued_;
+}
+
+void
+ThreadPoolExecutor::post(const std::shared_ptr<Strand> &_strand, Task _task) {
+    pool_->post([this, _strand, _task]() {
+        run(_strand, _task);
+    });
+}
+
+void
+ThreadPoolExecutor::run(const std::shared_ptr<Strand> &_strand, const Task &_task) {
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        queued_--;
+    }
+
+    _task();
+
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    if (_strand) {
+        // Schedule the next call of the strand instead of running it here,
+        // to let the calls of other strands take turns.
+        if (_strand->tasks_.empty()) {
+            if (_strand->client_)
+                clientStrands_.erase(_strand->client_);
+            else
+                methodStrands_.erase(_strand->method_);
+        } else {
+            Task itsNext = std::move(_strand->tasks_.front());
+            _strand->tasks_.pop_front();
+            post(_strand, std::move(itsNext));
+        }
+    }
+
+    // Nothing must be accessed after the last call was finished, as the
+    // executor might be destroyed as soon as the lock is released.
+    if (0 == --pending_)
+        finished_.notify_all();
+}
+
+} // namespace CommonAPI
@@ -3,7 +3,18 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 #include <CommonAPI/IniFileReader.hpp>
@@ -26,8 +37,80 @@ IniFileReader::Section::getValue(const std::string &_key) const {
     return ("");
 }
 
+StringView
+IniFileReader::Section::getValueView(const StringView &_key) const {
+    auto it = mappings_.find(_key.toString());
+    if (it != mappings_.end()) {
+        return StringView(it->second);
+    }
+    return StringView();
+}
+
+struct IniFileReader::Scan {
+    struct SectionView {
+        StringView name_;
+        std::size_t first_;
+        std::size_t count_;
+    };
+
+    struct EntryView {
+        std::size_t section_;
+        StringView key_;
+        StringView value_;
+        std::size_t line_;
+    };
+
+    Scan() {}
+    Scan(const Scan &_other);
+    Scan &operator=(const Scan &) = delete;
+
+    void parse();
+    const SectionView *findSection(const StringView &_section) const;
+
+    std::string content_;
+    std::vector<SectionView> sections_;
+    std::vector<EntryView> entries_;
+};
+
+IniFileReader::Scan::Scan(const Scan &_other)
+    : content_(_other.content_),
+      sections_(_other.sections_),
+      entries_(_other.entries_) {
+    // Let the copied views refer to the own content
+    auto rebase = [this, &_other](StringView &_view) {
+        _view = StringView(content_.data() + (_view.data() - _other.content_.data()), _view.size());
+    };
+    for (auto &section : sections_)
+        rebase(section.name_);
+    for (auto &entry : entries_) {
+        rebase(entry.key_);
+        rebase(entry.value_);
+    }
+}
+
+IniFileReader::IniFileReader() {
+}
+
+IniFileReader::IniFileReader(const IniFileReader &_other)
+    : sections_(_other.sections_),
+      scan_(_other.scan_ ? new Scan(*_other.scan_) : nullptr) {
+}
+
+IniFileReader::~IniFileReader() {
+}
+
+IniFileReader &
+IniFileReader::operator=(const IniFileReader &_other) {
+    if (this != &_other) {
+        sections_ = _other.sections_;
+        scan_.reset(_other.scan_ ? new Scan(*_other.scan_) : nullptr);
+    }
+    return (*this);
+}
+
 bool
 IniFileReader::load(const std::string &_path) {
+    reset();
     std::ifstream configStream(_path);
     if (configStream.is_open()) {
         COMMONAPI_INFO("Loading ini file from ", _path);
@@ -94,6 +177,301 @@ IniFileReader::load(const std::string &_path) {
     return true;
 }
 
+#ifndef WIN32
+static IniFileReader::FileStatus
+getFileStatus(const struct stat &_status) {
+    IniFileReader::FileStatus itsStatus;
+    itsStatus.isValid_ = true;
+    itsStatus.size_ = uint64_t(_status.st_size);
+    itsStatus.seconds_ = int64_t(_status.st_mtim.tv_sec);
+    itsStatus.nanoseconds_ = int64_t(_status.st_mtim.tv_nsec);
+    return itsStatus;
+}
+#endif
+
+bool
+IniFileReader::scan(const std::string &_path) {
+    FileStatus itsStatus;
+    return scan(_path, itsStatus);
+}
+
+bool
+IniFileReader::scan(const std::string &_path, FileStatus &_status) {
+    _status = FileStatus();
+    reset();
+    sections_.clear();
+
+    // The file is read into a single buffer instead of being mapped. A
+    // mapping of a file that is rewritten meanwhile, e.g. while the
+    // configuration is reloaded, raises SIGBUS on access.
+    std::unique_ptr<Scan> itsScan(new Scan());
+    std::string &itsContent = itsScan->content_;
+#ifdef WIN32
+    std::ifstream configStream(_path, std::ifstream::binary);
+    if (!configStream.is_open())
+        return true;
+    itsContent.assign(std::istreambuf_iterator<char>(configStream), std::istreambuf_iterator<char>());
+#else
+    int itsFd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (itsFd < 0)
+        return true;
+
+    struct stat itsStatus;
+    if (fstat(itsFd, &itsStatus) != 0) {
+        close(itsFd);
+        return false;
+    }
+
+    // The size is only a hint, the file is read up to its end
+    itsContent.resize(static_cast<std::size_t>(itsStatus.st_size) + 1);
+    std::size_t itsSize(0);
+    for (;;) {
+        if (itsSize == itsContent.size())
+            itsContent.resize(2 * itsContent.size());
+        ssize_t itsRead = read(itsFd, &itsContent[itsSize], itsContent.size() - itsSize);
+        if (itsRead < 0 && errno == EINTR)
+            continue;
+        if (itsRead < 0) {
+            close(itsFd);
+            itsContent.clear();
+            return false;
+        }
+        if (itsRead == 0)
+            break;
+        itsSize += std::size_t(itsRead);
+    }
+    itsContent.resize(itsSize);
+
+    // Compare with the status after reading, a file that changed meanwhile
+    // may have been read partially
+    FileStatus itsBefore = getFileStatus(itsStatus);
+    if (fstat(itsFd, &itsStatus) == 0) {
+        FileStatus itsAfter = getFileStatus(itsStatus);
+        if (itsAfter.size_ == itsBefore.size_
+                && itsAfter.seconds_ == itsBefore.seconds_
+                && itsAfter.nanoseconds_ == itsBefore.nanoseconds_)
+            _status = itsBefore;
+    }
+    close(itsFd);
+#endif
+
+    COMMONAPI_INFO("Scanning ini file from ", _path);
+    itsScan->parse();
+    scan_ = std::move(itsScan);
+    return true;
+}
+
+void
+IniFileReader::reset() {
+    scan_.reset();
+}
+
+static StringView
+trimView(const StringView &_view) {
+    std::size_t itsStart(0), itsEnd(_view.size());
+    while (itsStart < itsEnd && isspace(static_cast<unsigned char>(_view[itsStart])))
+        itsStart++;
+    while (itsEnd > itsStart && isspace(static_cast<unsigned char>(_view[itsEnd - 1])))
+        itsEnd--;
+    return _view.substr(itsStart, itsEnd - itsStart);
+}
+
+/*
+ * Collects views of all sections and keys in a single pass and sorts them
+ * afterwards. Double definitions are resolved as load() does: the first
+ * definition of a section or key is kept.
+ */
+void
+IniFileReader::Scan::parse() {
+    struct ScannedSection {
+        StringView name_;
+        std::size_t line_;
+        bool isValid_;
+    };
+    std::vector<ScannedSection> itsSections;
+    std::vector<EntryView> itsEntries;
+
+    const std::size_t NO_SECTION(static_cast<std::size_t>(-1));
+    std::size_t currentSection(NO_SECTION);
+    std::size_t lineCounter(0);
+    std::size_t itsPosition(0);
+    const char *itsData = content_.data();
+    const std::size_t itsSize = content_.size();
+    while (itsPosition < itsSize) {
+        const char *itsStart = itsData + itsPosition;
+        const char *itsNewline = static_cast<const char *>(std::memchr(itsStart, '\n', itsSize - itsPosition));
+        std::size_t itsLength = (itsNewline ? std::size_t(itsNewline - itsStart) : itsSize - itsPosition);
+        itsPosition += itsLength + 1;
+        lineCounter++;
+
+        StringView line = trimView(StringView(itsStart, itsLength));
+        if (line.size() > 0 && line[0] == '[') {
+            std::size_t end = line.find(']');
+            if (end != StringView::npos) {
+                ScannedSection itsSection;
+                itsSection.name_ = line.substr(1, end - 1);
+                itsSection.line_ = lineCounter;
+                itsSection.isValid_ = true;
+                currentSection = itsSections.size();
+                itsSections.push_back(itsSection);
+            } else {
+                COMMONAPI_ERROR("Missing \']\' in section definition (line ",
+                                lineCounter, ")");
+            }
+        } else if (currentSection != NO_SECTION) {
+            std::size_t pos = line.find('=');
+            if (pos != StringView::npos) {
+                EntryView itsEntry;
+                itsEntry.section_ = currentSection;
+                itsEntry.key_ = trimView(line.substr(0, pos));
+                itsEntry.value_ = trimView(line.substr(pos + 1));
+                itsEntry.line_ = lineCounter;
+                itsEntries.push_back(itsEntry);
+            } else if (line.size() > 0) {
+                COMMONAPI_ERROR("Missing \'=\' in key=value definition (line ",
+                                lineCounter, ")");
+            }
+        }
+    }
+
+    // Sort sections by name, the first of equally named sections wins
+    std::vector<std::size_t> itsOrder(itsSections.size());
+    for (std::size_t i = 0; i < itsOrder.size(); i++)
+        itsOrder[i] = i;
+    std::stable_sort(itsOrder.begin(), itsOrder.end(), [&itsSections](std::size_t _a, std::size_t _b) {
+        return (itsSections[_a].name_ < itsSections[_b].name_);
+    });
+
+    std::vector<std::size_t> itsIndex(itsSections.size(), NO_SECTION);
+    for (std::size_t i = 0; i < itsOrder.size(); i++) {
+        ScannedSection &itsSection = itsSections[itsOrder[i]];
+        if (i > 0 && itsSections[itsOrder[i-1]].name_ == itsSection.name_) {
+            COMMONAPI_ERROR("Double definition of section \'",
+                            itsSection.name_,
+                            "\' ignoring definition (line ",
+                            itsSection.line_,
+                            ")");
+            itsSection.isValid_ = false;
+            continue;
+        }
+
+        SectionView itsView;
+        itsView.name_ = itsSection.name_;
+        itsView.first_ = 0;
+        itsView.count_ = 0;
+        itsIndex[itsOrder[i]] = sections_.size();
+        sections_.push_back(itsView);
+    }
+
+    // Sort keys by section and name, the first definition of a key wins
+    itsEntries.erase(std::remove_if(itsEntries.begin(), itsEntries.end(),
+        [&itsSections](const EntryView &_entry) {
+            return !itsSections[_entry.section_].isValid_;
+        }), itsEntries.end());
+    for (auto &entry : itsEntries)
+        entry.section_ = itsIndex[entry.section_];
+    std::stable_sort(itsEntries.begin(), itsEntries.end(),
+        [](const EntryView &_a, const EntryView &_b) {
+            return (_a.section_ < _b.section_
+                    || (_a.section_ == _b.section_ && _a.key_ < _b.key_));
+        });
+
+    entries_.reserve(itsEntries.size());
+    for (std::size_t i = 0; i < itsEntries.size(); i++) {
+        const EntryView &itsEntry = itsEntries[i];
+        if (i > 0
+                && itsEntries[i-1].section_ == itsEntry.section_
+                && itsEntries[i-1].key_ == itsEntry.key_) {
+            COMMONAPI_ERROR("Double definition for key \'",
+                            itsEntry.key_,
+                            "'\' in section \'",
+                            sections_[itsEntry.section_].name_,
+                            "\' (line ",
+                            itsEntry.line_,
+                            ")");
+            continue;
+        }
+
+        SectionView &itsSection = sections_[itsEntry.section_];
+        if (0 == itsSection.count_)
+            itsSection.first_ = entries_.size();
+        itsSection.count_++;
+        entries_.push_back(itsEntry);
+    }
+}
+
+const IniFileReader::Scan::SectionView *
+IniFileReader::Scan::findSection(const StringView &_section) const {
+    auto itsSection = std::lower_bound(sections_.begin(), sections_.end(), _section,
+        [](const SectionView &_candidate, const StringView &_name) {
+            return (_candidate.name_ < _name);
+        });
+    if (itsSection != sections_.end() && itsSection->name_ == _section)
+        return &(*itsSection);
+    return nullptr;
+}
+
+bool
+IniFileReader::hasSection(const StringView &_section) const {
+    if (scan_)
+        return (nullptr != scan_->findSection(_section));
+    return (sections_.end() != sections_.find(_section.toString()));
+}
+
+StringView
+IniFileReader::getValueView(const StringView &_section, const StringView &_key) const {
+    if (!scan_) {
+        std::shared_ptr<Section> itsSection = getSection(_section.toString());
+        return (itsSection ? itsSection->getValueView(_key) : StringView());
+    }
+
+    const Scan::SectionView *itsSection = scan_->findSection(_section);
+    if (!itsSection)
+        return StringView();
+
+    auto itsBegin = scan_->entries_.begin() + std::ptrdiff_t(itsSection->first_);
+    auto itsEnd = itsBegin + std::ptrdiff_t(itsSection->count_);
+    auto itsEntry = std::lower_bound(itsBegin, itsEnd, _key,
+        [](const Scan::EntryView &_candidate, const StringView &_name) {
+            return (_candidate.key_ < _name);
+        });
+    if (itsEntry != itsEnd && itsEntry->key_ == _key)
+        return itsEntry->value_;
+    return StringView();
+}
+
+std::vector<StringView>
+IniFileReader::getSectionNames() const {
+    std::vector<StringView> itsNames;
+    if (scan_) {
+        for (auto &section : scan_->sections_)
+            itsNames.push_back(section.name_);
+    } else {
+        for (auto &section : sections_)
+            itsNames.push_back(StringView(section.first));
+    }
+    return itsNames;
+}
+
+void
+IniFileReader::forEach(const StringView &_section, const MappingHandler &_handler) const {
+    if (!scan_) {
+        std::shared_ptr<Section> itsSection = getSection(_section.toString());
+        if (itsSection) {
+            for (auto &m : itsSection->mappings_)
+                _handler(StringView(m.first), StringView(m.second));
+        }
+        return;
+    }
+
+    const Scan::SectionView *itsSection = scan_->findSection(_section);
+    if (!itsSection)
+        return;
+
+    for (std::size_t i = itsSection->first_; i < itsSection->first_ + itsSection->count_; i++)
+        _handler(scan_->entries_[i].key_, scan_->entries_[i].value_);
+}
+
 const std::map<std::string, std::shared_ptr<IniFileReader::Section>> &
 IniFileReader::getSections() const {
     return sections_;
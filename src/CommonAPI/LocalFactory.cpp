@@ -0,0 +1,225 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <CommonAPI/LocalFactory.hpp>
+#include <CommonAPI/Logger.hpp>
+#include <CommonAPI/MainLoopContext.hpp>
+#include <CommonAPI/Runtime.hpp>
+#include <CommonAPI/ThreadPool.hpp>
+
+namespace CommonAPI {
+
+// Does nothing once the dispatcher is gone, the main loop might still call
+// the source until it processed the deregistration
+struct LocalDispatcher::Source : public DispatchSource {
+    Source(const std::weak_ptr<LocalDispatcher> &_dispatcher)
+        : dispatcher_(_dispatcher) {
+    }
+
+    bool prepare(int64_t &_timeout) {
+        _timeout = TIMEOUT_INFINITE;
+        std::shared_ptr<LocalDispatcher> itsDispatcher = dispatcher_.lock();
+        return (itsDispatcher && itsDispatcher->hasTasks());
+    }
+
+    bool check() {
+        std::shared_ptr<LocalDispatcher> itsDispatcher = dispatcher_.lock();
+        return (itsDispatcher && itsDispatcher->hasTasks());
+    }
+
+    bool dispatch() {
+        std::shared_ptr<LocalDispatcher> itsDispatcher = dispatcher_.lock();
+        return (itsDispatcher && itsDispatcher->runTasks());
+    }
+
+    std::weak_ptr<LocalDispatcher> dispatcher_;
+};
+
+LocalDispatcher::LocalDispatcher(std::shared_ptr<MainLoopContext> _context)
+    : context_(_context),
+      isScheduled_(false) {
+}
+
+LocalDispatcher::~LocalDispatcher() {
+    if (context_ && source_)
+        context_->deregisterDispatchSource(source_.get());
+}
+
+void
+LocalDispatcher::post(Task _task) {
+    // The source refers to the dispatcher by a weak pointer, which is not
+    // available before the constructor returned
+    if (context_) {
+        std::call_once(isRegistered_, [this]() {
+            source_ = std::unique_ptr<Source>(new Source(shared_from_this()));
+            context_->registerDispatchSource(source_.get());
+        });
+    }
+
+    std::unique_lock<std::mutex> itsLock(mutex_);
+    tasks_.push_back(std::move(_task));
+    if (context_) {
+        itsLock.unlock();
+        context_->wakeup();
+    } else if (!isScheduled_) {
+        isScheduled_ = true;
+        itsLock.unlock();
+        schedule();
+    }
+}
+
+void
+LocalDispatcher::schedule() {
+    std::shared_ptr<LocalDispatcher> self = shared_from_this();
+    Runtime::instance().getThreadPool()->post([self]() {
+        // Requeue instead of looping to give other dispatchers a chance
+        if (self->runTasks())
+            self->schedule();
+    });
+}
+
+const std::shared_ptr<MainLoopContext> &
+LocalDispatcher::getContext() const {
+    return context_;
+}
+
+bool
+LocalDispatcher::hasTasks() {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    return !tasks_.empty();
+}
+
+bool
+LocalDispatcher::runTasks() {
+    std::deque<Task> itsTasks;
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        itsTasks.swap(tasks_);
+    }
+
+    for (auto &task : itsTasks)
+        task();
+
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    if (tasks_.empty()) {
+        isScheduled_ = false;
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<LocalFactory>
+LocalFactory::get() {
+    static std::shared_ptr<LocalFactory> theFactory = std::make_shared<LocalFactory>();
+    return theFactory;
+}
+
+void
+LocalFactory::registerProxyCreateMethod(const std::string &_interface, ProxyCreateFunction _function) {
+    COMMONAPI_DEBUG("Registering local proxy create method for interface=", _interface);
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    proxyCreateFunctions_[_interface] = _function;
+}
+
+std::shared_ptr<StubBase>
+LocalFactory::getStub(const Address &_address) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    auto foundService = services_.find(_address);
+    if (foundService != services_.end())
+        return foundService->second.stub_;
+    return nullptr;
+}
+
+std::shared_ptr<Proxy>
+LocalFactory::createProxy(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                          const ConnectionId_t &_connectionId) {
+    if (!getStub(Address(_domain, _interface, _instance)))
+        return nullptr;
+    return createLocalProxy(_domain, _interface, _instance, getDispatcher(_connectionId));
+}
+
+std::shared_ptr<Proxy>
+LocalFactory::createProxy(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                          std::shared_ptr<MainLoopContext> _context) {
+    if (!getStub(Address(_domain, _interface, _instance)))
+        return nullptr;
+    return createLocalProxy(_domain, _interface, _instance,
+                            (_context ? std::make_shared<LocalDispatcher>(_context) : nullptr));
+}
+
+bool
+LocalFactory::registerStub(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                           std::shared_ptr<StubBase> _stub, const ConnectionId_t &_connectionId) {
+    (void)_connectionId;
+    return addService(_domain, _interface, _instance, _stub, std::make_shared<LocalDispatcher>(nullptr));
+}
+
+bool
+LocalFactory::registerStub(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                           std::shared_ptr<StubBase> _stub, std::shared_ptr<MainLoopContext> _context) {
+    return addService(_domain, _interface, _instance, _stub, std::make_shared<LocalDispatcher>(_context));
+}
+
+bool
+LocalFactory::unregisterStub(const std::string &_domain, const std::string &_interface, const std::string &_instance) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    return (services_.erase(Address(_domain, _interface, _instance)) > 0);
+}
+
+std::shared_ptr<Proxy>
+LocalFactory::createLocalProxy(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                               const std::shared_ptr<LocalDispatcher> &_proxyDispatcher) {
+    Address itsAddress(_domain, _interface, _instance);
+    ProxyCreateFunction itsFunction;
+    Service itsService;
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        auto foundFunction = proxyCreateFunctions_.find(_interface);
+        if (foundFunction == proxyCreateFunctions_.end())
+            return nullptr;
+
+        auto foundService = services_.find(itsAddress);
+        if (foundService == services_.end())
+            return nullptr;
+
+        itsFunction = foundFunction->second;
+        itsService = foundService->second;
+    }
+
+    COMMONAPI_DEBUG("Creating local proxy for ", itsAddress);
+    return itsFunction(itsAddress, itsService.stub_, itsService.dispatcher_, _proxyDispatcher);
+}
+
+// Proxies of the same connection share a dispatcher, as they would share
+// the dispatching thread of a binding's connection
+std::shared_ptr<LocalDispatcher>
+LocalFactory::getDispatcher(const ConnectionId_t &_connectionId) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    std::shared_ptr<LocalDispatcher> itsDispatcher = dispatchers_[_connectionId].lock();
+    if (!itsDispatcher) {
+        for (auto it = dispatchers_.begin(); it != dispatchers_.end();) {
+            if (it->second.expired())
+                it = dispatchers_.erase(it);
+            else
+                ++it;
+        }
+        itsDispatcher = std::make_shared<LocalDispatcher>(nullptr);
+        dispatchers_[_connectionId] = itsDispatcher;
+    }
+    return itsDispatcher;
+}
+
+bool
+LocalFactory::addService(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                         const std::shared_ptr<StubBase> &_stub, const std::shared_ptr<LocalDispatcher> &_dispatcher) {
+    Service itsService;
+    itsService.stub_ = _stub;
+    itsService.dispatcher_ = _dispatcher;
+
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    return services_.insert(std::make_pair(Address(_domain, _interface, _instance), itsService)).second;
+}
+
+} // namespace CommonAPI
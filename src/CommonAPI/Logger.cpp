@@ -15,19 +15,20 @@ std::mutex Logger::mutex_;
 #endif
 
 #ifdef USE_CONSOLE
-bool Logger::useConsole_(true);
+std::atomic<bool> Logger::useConsole_(true);
 #endif
 
 #ifdef USE_FILE
 std::shared_ptr<std::ofstream> Logger::file_;
+std::string Logger::fileName_;
 #endif
 
 #ifdef USE_DLT
-bool Logger::useDlt_(false);
+std::atomic<bool> Logger::useDlt_(false);
 #endif
 
 #if defined(USE_CONSOLE) || defined(USE_FILE) || defined(USE_DLT)
-Logger::Level Logger::maximumLogLevel_(Logger::Level::LL_INFO);
+std::atomic<Logger::Level> Logger::maximumLogLevel_(Logger::Level::LL_INFO);
 #endif
 
 Logger::Logger() {
@@ -54,10 +55,18 @@ Logger::init(bool _useConsole, const std::string &_fileName, bool _useDlt, const
     (void)_useConsole;
 #endif
 #ifdef USE_FILE
-    if (_fileName != "") {
-        file_ = std::make_shared<std::ofstream>();
-        if (file_)
-            file_->open(_fileName.c_str(), std::ofstream::out | std::ofstream::app);
+    {
+        // Keep the file open if it did not change
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        if (_fileName != fileName_) {
+            fileName_ = _fileName;
+            file_.reset();
+            if (_fileName != "") {
+                file_ = std::make_shared<std::ofstream>();
+                if (file_)
+                    file_->open(_fileName.c_str(), std::ofstream::out | std::ofstream::app);
+            }
+        }
     }
 #else
     (void)_fileName;
@@ -81,9 +90,10 @@ Logger::doLog(Level _level, const std::string &_message) {
     }
 #endif
 #ifdef USE_FILE
-    if (file_ && file_->is_open()) {
+    {
         std::lock_guard<std::mutex> itsLock(mutex_);
-        (*(file_.get())) << "[CAPI][" << levelAsString(_level) << "] " << _message << std::endl;
+        if (file_ && file_->is_open())
+            (*(file_.get())) << "[CAPI][" << levelAsString(_level) << "] " << _message << std::endl;
     }
 #endif
 #ifdef USE_DLT
@@ -3,16 +3,255 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
 #include <CommonAPI/ProxyManager.hpp>
 #include <CommonAPI/Runtime.hpp>
 
 namespace CommonAPI {
 
+static const std::chrono::milliseconds DEFAULT_DISCOVERY_CACHE_TIMEOUT(10000);
+
+struct ProxyManager::DiscoveryCache {
+    DiscoveryCache()
+        : isValid_(false),
+          isRefreshing_(false),
+          generation_(0),
+          lastStatus_(CallStatus::SUCCESS),
+          timeout_(DEFAULT_DISCOVERY_CACHE_TIMEOUT) {
+    }
+
+    void onChanged(const std::string &_instance, const AvailabilityStatus &_status) {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        if (isRefreshing_) {
+            // Might not be contained in the result of the running query
+            changes_.push_back(std::make_pair(_instance, _status));
+        } else if (isValid_) {
+            apply(_instance, _status);
+        }
+    }
+
+    void onError() {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        invalidate();
+    }
+
+    void apply(const std::string &_instance, const AvailabilityStatus &_status) {
+        if (_status == AvailabilityStatus::AVAILABLE)
+            instances_.insert(_instance);
+        else
+            instances_.erase(_instance);
+    }
+
+    void invalidate() {
+        isValid_ = false;
+        generation_++;
+    }
+
+    bool isUsable() const {
+        return (isValid_
+                && (timeout_.count() == 0
+                    || std::chrono::steady_clock::now() - refreshed_ < timeout_));
+    }
+
+    std::once_flag subscription_;
+
+    std::mutex mutex_;
+    std::condition_variable refreshCondition_;
+
+    bool isValid_;
+    bool isRefreshing_;
+    uint32_t generation_;
+    CallStatus lastStatus_;
+
+    std::chrono::milliseconds timeout_;
+    std::chrono::steady_clock::time_point refreshed_;
+
+    std::set<std::string> instances_;
+    std::vector<std::pair<std::string, AvailabilityStatus>> changes_;
+};
+
+/*
+ * Discovery caches of the proxy managers, kept apart to leave the layout of
+ * ProxyManager unchanged. The table is never destroyed, as proxy managers
+ * may be destroyed during static destruction.
+ */
+struct DiscoveryCaches {
+    std::mutex mutex_;
+    std::unordered_map<const ProxyManager *, std::shared_ptr<void>> caches_;
+};
+
+static DiscoveryCaches &
+getDiscoveryCaches() {
+    static DiscoveryCaches *theCaches = new DiscoveryCaches();
+    return *theCaches;
+}
+
+/*
+ * Held by the listeners of a cache. The event of a proxy manager, and with
+ * it its listeners, is destroyed with the manager, also with destructors
+ * that were compiled before the cache existed. The cache is then removed,
+ * a manager constructed at the same address starts with a new one.
+ */
+struct DiscoveryCacheRegistration {
+    DiscoveryCacheRegistration(const ProxyManager *_manager, const void *_cache)
+        : manager_(_manager), cache_(_cache) {
+    }
+
+    ~DiscoveryCacheRegistration() {
+        DiscoveryCaches &itsCaches = getDiscoveryCaches();
+        std::lock_guard<std::mutex> itsLock(itsCaches.mutex_);
+        auto foundCache = itsCaches.caches_.find(manager_);
+        if (foundCache != itsCaches.caches_.end() && foundCache->second.get() == cache_)
+            itsCaches.caches_.erase(foundCache);
+    }
+
+    const ProxyManager *manager_;
+    const void *cache_;
+};
+
+std::shared_ptr<ProxyManager::DiscoveryCache>
+ProxyManager::getDiscoveryCache() {
+    std::shared_ptr<DiscoveryCache> itsCache;
+    {
+        DiscoveryCaches &itsCaches = getDiscoveryCaches();
+        std::lock_guard<std::mutex> itsLock(itsCaches.mutex_);
+        std::shared_ptr<void> &itsEntry = itsCaches.caches_[this];
+        if (!itsEntry)
+            itsEntry = std::make_shared<DiscoveryCache>();
+        itsCache = std::static_pointer_cast<DiscoveryCache>(itsEntry);
+    }
+
+    // Subscribe before the first query to not miss changes. The binding may
+    // notify the listener from within subscribe, so no lock is held. Other
+    // threads wait until the subscription is done.
+    std::call_once(itsCache->subscription_, [this, &itsCache]() {
+        std::weak_ptr<DiscoveryCache> itsWeakCache(itsCache);
+        std::shared_ptr<DiscoveryCacheRegistration> itsRegistration
+            = std::make_shared<DiscoveryCacheRegistration>(this, itsCache.get());
+        getInstanceAvailabilityStatusChangedEvent().subscribe(
+            [itsWeakCache, itsRegistration](const std::string &_instance,
+                                            const AvailabilityStatus &_availabilityStatus) {
+                std::shared_ptr<DiscoveryCache> itsCache = itsWeakCache.lock();
+                if (itsCache)
+                    itsCache->onChanged(_instance, _availabilityStatus);
+            },
+            [itsWeakCache, itsRegistration](const CallStatus) {
+                std::shared_ptr<DiscoveryCache> itsCache = itsWeakCache.lock();
+                if (itsCache)
+                    itsCache->onError();
+            });
+    });
+
+    return itsCache;
+}
+
+void
+ProxyManager::getCachedAvailableInstances(CallStatus &_status,
+                                          std::vector<std::string> &_instances) {
+    if (!refreshDiscoveryCache(_status)) {
+        if (_status == CallStatus::SUCCESS)
+            getAvailableInstances(_status, _instances);
+        return;
+    }
+
+    std::shared_ptr<DiscoveryCache> itsCache = getDiscoveryCache();
+    std::lock_guard<std::mutex> itsLock(itsCache->mutex_);
+    _instances.assign(itsCache->instances_.begin(), itsCache->instances_.end());
+}
+
+void
+ProxyManager::getCachedInstanceAvailabilityStatus(const std::string &_instance,
+                                                  CallStatus &_status,
+                                                  AvailabilityStatus &_availabilityStatus) {
+    if (!refreshDiscoveryCache(_status)) {
+        getInstanceAvailabilityStatus(_instance, _status, _availabilityStatus);
+        return;
+    }
+
+    std::shared_ptr<DiscoveryCache> itsCache = getDiscoveryCache();
+    std::lock_guard<std::mutex> itsLock(itsCache->mutex_);
+    _availabilityStatus = (itsCache->instances_.count(_instance) > 0 ?
+                            AvailabilityStatus::AVAILABLE :
+                            AvailabilityStatus::NOT_AVAILABLE);
+}
+
+void
+ProxyManager::setDiscoveryCacheTimeout(std::chrono::milliseconds _timeout) {
+    std::shared_ptr<DiscoveryCache> itsCache = getDiscoveryCache();
+    std::lock_guard<std::mutex> itsLock(itsCache->mutex_);
+    itsCache->timeout_ = _timeout;
+}
+
+void
+ProxyManager::invalidateDiscoveryCache() {
+    std::shared_ptr<DiscoveryCache> itsCache = getDiscoveryCache();
+    std::lock_guard<std::mutex> itsLock(itsCache->mutex_);
+    itsCache->invalidate();
+}
+
 std::shared_ptr<Proxy>
 ProxyManager::createProxy(
         const std::string &_domain, const std::string &_interface, const std::string &_instance,
         const ConnectionId_t &_connection) const {
-    return Runtime::get()->createProxy(_domain, _interface, _instance, _connection);
+    return Runtime::instance().createProxy(_domain, _interface, _instance, _connection);
+}
+
+std::vector<std::shared_ptr<Proxy>>
+ProxyManager::createProxies(
+        const std::string &_domain, const std::string &_interface,
+        const std::vector<std::string> &_instances,
+        const ConnectionId_t &_connection) const {
+    return Runtime::instance().createProxies(_domain, _interface, _instances, _connection);
+}
+
+/*
+ * Returns true if the cache can answer queries. Otherwise, _status contains
+ * the result of the failed query, or SUCCESS if the cache was invalidated
+ * while the query was running.
+ */
+bool
+ProxyManager::refreshDiscoveryCache(CallStatus &_status) {
+    std::shared_ptr<DiscoveryCache> itsCache = getDiscoveryCache();
+    std::unique_lock<std::mutex> itsLock(itsCache->mutex_);
+
+    // Share the result of a running query
+    if (itsCache->isRefreshing_) {
+        itsCache->refreshCondition_.wait(itsLock, [&itsCache]() { return !itsCache->isRefreshing_; });
+        _status = itsCache->lastStatus_;
+        return itsCache->isUsable();
+    }
+
+    if (itsCache->isUsable()) {
+        _status = CallStatus::SUCCESS;
+        return true;
+    }
+
+    itsCache->isRefreshing_ = true;
+    uint32_t itsGeneration = itsCache->generation_;
+    itsLock.unlock();
+
+    std::vector<std::string> itsInstances;
+    getAvailableInstances(_status, itsInstances);
+
+    itsLock.lock();
+    if (_status == CallStatus::SUCCESS && itsGeneration == itsCache->generation_) {
+        itsCache->instances_.clear();
+        itsCache->instances_.insert(itsInstances.begin(), itsInstances.end());
+        for (auto &change : itsCache->changes_)
+            itsCache->apply(change.first, change.second);
+        itsCache->isValid_ = true;
+        itsCache->refreshed_ = std::chrono::steady_clock::now();
+    }
+    itsCache->changes_.clear();
+    itsCache->isRefreshing_ = false;
+    itsCache->lastStatus_ = _status;
+    itsCache->refreshCondition_.notify_all();
+
+    return itsCache->isUsable();
 }
 
 } // namespace CommonAPI
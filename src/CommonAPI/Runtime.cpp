@@ -7,17 +7,26 @@
 #include <Windows.h>
 #else
 #include <dlfcn.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <unistd.h>
 #endif
 
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <thread>
 
+#include <CommonAPI/ConfigurationCache.hpp>
 #include <CommonAPI/Factory.hpp>
 #include <CommonAPI/IniFileReader.hpp>
 #include <CommonAPI/Logger.hpp>
+#include <CommonAPI/MainLoopContext.hpp>
 #include <CommonAPI/Runtime.hpp>
+#include <CommonAPI/ThreadPool.hpp>
 
 namespace CommonAPI {
 
@@ -26,20 +35,328 @@ const char *COMMONAPI_DEFAULT_FOLDER = "/usr/local/lib/commonapi";
 const char *COMMONAPI_DEFAULT_CONFIG_FILE = "commonapi.ini";
 const char *COMMONAPI_DEFAULT_CONFIG_FOLDER = "/etc";
 
-std::map<std::string, std::string> properties__;
 std::shared_ptr<Runtime> Runtime::theRuntime__ = std::make_shared<Runtime>();
 
+/*
+ * Open addressing hash table mapping (domain, interface, connection) to the
+ * factory that is responsible for it. Entries are only added, never removed,
+ * and are written by a single writer at a time. Therefore readers can probe
+ * the table without taking routesMutex_. A full or invalidated table is
+ * replaced as a whole and freed once the last reader released it.
+ */
+class RoutingTable {
+public:
+    struct Route {
+        std::size_t hash_;
+        std::string domain_;
+        std::string interface_;
+        std::string connection_;
+        std::shared_ptr<Factory> factory_;
+    };
+
+    RoutingTable(std::size_t _capacity)
+        : capacity_(_capacity), size_(0),
+          slots_(new std::atomic<Route *>[_capacity]()),
+          routes_(new Route[_capacity / 2]) {
+    }
+
+    static std::size_t hash(const std::string &_domain,
+                            const std::string &_interface,
+                            const std::string &_connection) {
+        std::hash<std::string> hasher;
+        std::size_t itsHash = hasher(_domain);
+        itsHash ^= hasher(_interface) + 0x9e3779b9 + (itsHash << 6) + (itsHash >> 2);
+        itsHash ^= hasher(_connection) + 0x9e3779b9 + (itsHash << 6) + (itsHash >> 2);
+        return itsHash;
+    }
+
+    std::shared_ptr<Factory> find(std::size_t _hash,
+                                  const std::string &_domain,
+                                  const std::string &_interface,
+                                  const std::string &_connection) const {
+        for (std::size_t i = 0; i < capacity_; i++) {
+            const Route *route = slots_[(_hash + i) % capacity_].load(std::memory_order_acquire);
+            if (!route)
+                break;
+            if (route->hash_ == _hash
+                    && route->domain_ == _domain
+                    && route->interface_ == _interface
+                    && route->connection_ == _connection)
+                return route->factory_;
+        }
+        return nullptr;
+    }
+
+    // Must only be called by a single writer at a time.
+    bool insert(std::size_t _hash,
+                const std::string &_domain,
+                const std::string &_interface,
+                const std::string &_connection,
+                const std::shared_ptr<Factory> &_factory) {
+        if (size_ == capacity_ / 2)
+            return false;
+
+        Route &route = routes_[size_++];
+        route.hash_ = _hash;
+        route.domain_ = _domain;
+        route.interface_ = _interface;
+        route.connection_ = _connection;
+        route.factory_ = _factory;
+
+        for (std::size_t i = 0; i < capacity_; i++) {
+            std::atomic<Route *> &slot = slots_[(_hash + i) % capacity_];
+            if (!slot.load(std::memory_order_relaxed)) {
+                slot.store(&route, std::memory_order_release);
+                break;
+            }
+        }
+        return true;
+    }
+
+    std::size_t getCapacity() const {
+        return capacity_;
+    }
+
+    std::size_t getSize() const {
+        return size_;
+    }
+
+    const Route &getRoute(std::size_t _index) const {
+        return routes_[_index];
+    }
+
+private:
+    const std::size_t capacity_;
+    std::size_t size_;
+    std::unique_ptr<std::atomic<Route *>[]> slots_;
+    std::unique_ptr<Route[]> routes_;
+};
+
+static const std::size_t ROUTING_TABLE_INITIAL_CAPACITY(64);
+static const std::size_t PROXIES_PRUNE_SIZE(64);
+
+/*
+ * Library mappings of a configuration. They are looked up in the
+ * configuration cache if one is used, otherwise taken from the ini file.
+ */
+struct Runtime::Libraries {
+    std::map<std::string, std::map<bool, std::string>> mappings_;
+    std::shared_ptr<const ConfigurationCache> cache_;
+};
+
+#ifndef WIN32
+/*
+ * Watches the directory of the configuration file, as editors often
+ * replace a file instead of writing it. Either registered with a main loop
+ * context or dispatched by its own thread.
+ */
+class ConfigurationWatch : public Watch {
+public:
+    ConfigurationWatch(const std::string &_file, std::function<void()> _callback)
+        : callback_(_callback),
+          watchDescriptor_(-1),
+          wakeupFd_(-1),
+          isRunning_(false) {
+        std::size_t itsSeparator = _file.rfind('/');
+        if (itsSeparator == std::string::npos) {
+            directory_ = ".";
+            name_ = _file;
+        } else {
+            directory_ = (itsSeparator > 0 ? _file.substr(0, itsSeparator) : "/");
+            name_ = _file.substr(itsSeparator + 1);
+        }
+
+        pollFd_.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        pollFd_.events = POLLIN;
+        pollFd_.revents = 0;
+        if (pollFd_.fd >= 0)
+            watchDescriptor_ = inotify_add_watch(pollFd_.fd, directory_.c_str(),
+                                                 IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+
+    ~ConfigurationWatch() {
+        if (context_) {
+            context_->deregisterWatch(this);
+        } else if (isRunning_) {
+            isRunning_ = false;
+            (void)eventfd_write(wakeupFd_, 1);
+            thread_.join();
+        }
+        if (wakeupFd_ >= 0)
+            close(wakeupFd_);
+        if (pollFd_.fd >= 0)
+            close(pollFd_.fd);
+    }
+
+    bool isValid() const {
+        return (watchDescriptor_ >= 0);
+    }
+
+    void start(std::shared_ptr<MainLoopContext> _context) {
+        if (_context) {
+            context_ = _context;
+            context_->registerWatch(this);
+        } else {
+            wakeupFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            isRunning_ = true;
+            thread_ = std::thread(&ConfigurationWatch::run, this);
+        }
+    }
+
+    void dispatch(unsigned int _eventFlags) {
+        (void)_eventFlags;
+
+        bool isChanged(false);
+        alignas(inotify_event) char itsBuffer[4096];
+        ssize_t itsSize;
+        while ((itsSize = read(pollFd_.fd, itsBuffer, sizeof(itsBuffer))) > 0) {
+            const char *itsEnd = itsBuffer + itsSize;
+            for (const char *itsPosition = itsBuffer; itsPosition < itsEnd; ) {
+                const inotify_event *itsEvent = reinterpret_cast<const inotify_event *>(itsPosition);
+                if (itsEvent->len > 0 && name_ == itsEvent->name)
+                    isChanged = true;
+                itsPosition += sizeof(inotify_event) + itsEvent->len;
+            }
+        }
+
+        if (isChanged)
+            callback_();
+    }
+
+    const pollfd &getAssociatedFileDescriptor() {
+        return pollFd_;
+    }
+
+    const std::vector<DispatchSource *> &getDependentDispatchSources() {
+        return dependentSources_;
+    }
+
+private:
+    void run() {
+        pollfd itsFds[2];
+        itsFds[0] = pollFd_;
+        itsFds[1].fd = wakeupFd_;
+        itsFds[1].events = POLLIN;
+        while (isRunning_) {
+            itsFds[0].revents = itsFds[1].revents = 0;
+            if (poll(itsFds, 2, -1) < 0 && errno != EINTR) {
+                COMMONAPI_ERROR("Watching configuration file failed (", errno, ")");
+                break;
+            }
+            if (itsFds[0].revents)
+                dispatch(itsFds[0].revents);
+        }
+    }
+
+    std::string directory_;
+    std::string name_;
+    std::function<void()> callback_;
+
+    pollfd pollFd_;
+    int watchDescriptor_;
+    std::vector<DispatchSource *> dependentSources_;
+    std::shared_ptr<MainLoopContext> context_;
+
+    int wakeupFd_;
+    std::atomic<bool> isRunning_;
+    std::thread thread_;
+};
+#else
+class ConfigurationWatch {
+};
+#endif // !WIN32
+
+/*
+ * Properties are kept in immutable, sorted snapshots. Writers publish a new
+ * snapshot and increment the version. Readers keep a thread local copy of
+ * the snapshot pointer and only need to lock if the version changed since
+ * their last read.
+ */
+typedef std::vector<std::pair<std::string, std::string>> Properties;
+
+static std::shared_ptr<const Properties> properties__ = std::make_shared<const Properties>();
+static std::atomic<uint64_t> propertiesVersion__(1);
+static std::mutex propertiesMutex__;
+
+static std::list<PropertyChangedCallback> propertyListeners__;
+static std::mutex propertyListenersMutex__;
+
+struct PropertiesCache {
+    PropertiesCache() : version_(0) {}
+
+    uint64_t version_;
+    std::shared_ptr<const Properties> properties_;
+};
+
+static bool
+isPropertyLess(const std::pair<std::string, std::string> &_property, const StringView &_name) {
+    return (StringView(_property.first) < _name);
+}
+
 std::string
 Runtime::getProperty(const std::string &_name) {
-    auto foundProperty = properties__.find(_name);
-    if (foundProperty != properties__.end())
+    return getProperty(StringView(_name));
+}
+
+std::string
+Runtime::getProperty(const StringView &_name) {
+    static thread_local PropertiesCache itsCache;
+
+    uint64_t itsVersion = propertiesVersion__.load(std::memory_order_acquire);
+    if (itsVersion != itsCache.version_) {
+        std::lock_guard<std::mutex> itsLock(propertiesMutex__);
+        itsCache.properties_ = properties__;
+        itsCache.version_ = propertiesVersion__.load(std::memory_order_relaxed);
+    }
+
+    const Properties &itsProperties = *itsCache.properties_;
+    auto foundProperty = std::lower_bound(itsProperties.begin(), itsProperties.end(),
+                                          _name, isPropertyLess);
+    if (foundProperty != itsProperties.end() && StringView(foundProperty->first) == _name)
         return foundProperty->second;
     return "";
 }
 
 void
 Runtime::setProperty(const std::string &_name, const std::string &_value) {
-    properties__[_name] = _value;
+    {
+        std::lock_guard<std::mutex> itsLock(propertiesMutex__);
+        std::shared_ptr<Properties> itsProperties = std::make_shared<Properties>(*properties__);
+        auto foundProperty = std::lower_bound(itsProperties->begin(), itsProperties->end(),
+                                              StringView(_name), isPropertyLess);
+        if (foundProperty != itsProperties->end() && foundProperty->first == _name) {
+            if (foundProperty->second == _value)
+                return;
+            foundProperty->second = _value;
+        } else {
+            itsProperties->insert(foundProperty, std::make_pair(_name, _value));
+        }
+        properties__ = itsProperties;
+        propertiesVersion__.fetch_add(1, std::memory_order_release);
+    }
+
+    // Listeners are called on a copy, so they may set properties or
+    // (un)subscribe without deadlocking.
+    std::list<PropertyChangedCallback> itsListeners;
+    {
+        std::lock_guard<std::mutex> itsLock(propertyListenersMutex__);
+        itsListeners = propertyListeners__;
+    }
+    for (auto &listener : itsListeners)
+        listener(_name, _value);
+}
+
+PropertyChangedSubscription
+Runtime::subscribeForPropertyChanges(PropertyChangedCallback _callback) {
+    std::lock_guard<std::mutex> itsLock(propertyListenersMutex__);
+    propertyListeners__.emplace_front(_callback);
+    return propertyListeners__.begin();
+}
+
+void
+Runtime::unsubscribeForPropertyChanges(PropertyChangedSubscription _subscription) {
+    std::lock_guard<std::mutex> itsLock(propertyListenersMutex__);
+    propertyListeners__.erase(_subscription);
 }
 
 std::shared_ptr<Runtime> Runtime::get() {
@@ -47,13 +364,33 @@ std::shared_ptr<Runtime> Runtime::get() {
     return theRuntime__;
 }
 
+Runtime &Runtime::instance() {
+    theRuntime__->init();
+    return *theRuntime__;
+}
+
 Runtime::Runtime()
     : defaultBinding_(COMMONAPI_DEFAULT_BINDING),
-      defaultFolder_(COMMONAPI_DEFAULT_FOLDER) {
+      defaultFolder_(COMMONAPI_DEFAULT_FOLDER),
+      localFactory_(nullptr),
+      libraries_(std::make_shared<Libraries>()),
+      isPreloadEnabled_(false),
+      isProxyCacheEnabled_(false),
+      proxiesPruneSize_(PROXIES_PRUNE_SIZE),
+      isInitialized_(false) {
+    clearRoutes();
 }
 
 Runtime::~Runtime() {
-    // intentionally left empty
+    // Queued tasks refer to this runtime, drop them and wait for the running
+    // ones before any member is destroyed.
+    std::shared_ptr<ThreadPool> itsPool;
+    {
+        std::lock_guard<std::mutex> itsLock(threadPoolMutex_);
+        itsPool.swap(threadPool_);
+    }
+    if (itsPool)
+        itsPool->stop();
 }
 
 bool
@@ -63,8 +400,12 @@ Runtime::registerFactory(const std::string &_binding, std::shared_ptr<Factory> _
 #ifndef WIN32
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
 #endif
-    if (_binding == defaultBinding_) {
-        defaultFactory_ = _factory;
+    if (_binding == LOCAL_BINDING) {
+        localFactories_.push_back(_factory);
+        localFactory_.store(_factory.get(), std::memory_order_release);
+        isRegistered = true;
+    } else if (_binding == defaultBinding_) {
+        std::atomic_store(&defaultFactory_, _factory);
     } else {
         auto foundFactory = factories_.find(_binding);
         if (foundFactory == factories_.end()) {
@@ -72,6 +413,7 @@ Runtime::registerFactory(const std::string &_binding, std::shared_ptr<Factory> _
             isRegistered = true;
         }
     }
+    clearRoutes();
     return isRegistered;
 }
 
@@ -81,11 +423,105 @@ Runtime::unregisterFactory(const std::string &_binding) {
 #ifndef WIN32
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
 #endif
-    if (_binding == defaultBinding_) {
-        defaultFactory_.reset();
+    if (_binding == LOCAL_BINDING) {
+        localFactory_.store(nullptr, std::memory_order_release);
+    } else if (_binding == defaultBinding_) {
+        std::atomic_store(&defaultFactory_, std::shared_ptr<Factory>());
     } else {
         factories_.erase(_binding);
     }
+    clearRoutes();
+    return true;
+}
+
+void
+Runtime::setProxyCacheEnabled(bool _isEnabled) {
+    std::lock_guard<std::mutex> itsLock(proxiesMutex_);
+    isProxyCacheEnabled_ = _isEnabled;
+    if (!isProxyCacheEnabled_)
+        proxies_.clear();
+}
+
+// Removes the entries of destroyed proxies. Called with proxiesMutex_ locked
+// whenever a proxy was added; the cache is only scanned once it doubled in
+// size, which keeps insertion amortized constant.
+void
+Runtime::pruneProxies() {
+    if (proxies_.size() < proxiesPruneSize_)
+        return;
+
+    for (auto it = proxies_.begin(); it != proxies_.end();) {
+        if (it->second.expired())
+            it = proxies_.erase(it);
+        else
+            ++it;
+    }
+    proxiesPruneSize_ = std::max(PROXIES_PRUNE_SIZE, 2 * proxies_.size());
+}
+
+bool
+Runtime::isProxyCacheEnabled() const {
+    std::lock_guard<std::mutex> itsLock(proxiesMutex_);
+    return isProxyCacheEnabled_;
+}
+
+std::shared_ptr<ThreadPool>
+Runtime::getThreadPool() {
+    std::lock_guard<std::mutex> itsLock(threadPoolMutex_);
+    if (!threadPool_) {
+        std::size_t itsThreads = std::thread::hardware_concurrency();
+        threadPool_ = std::make_shared<ThreadPool>(itsThreads > 0 ? itsThreads : 1);
+    }
+    return threadPool_;
+}
+
+bool
+Runtime::watchConfiguration(std::shared_ptr<MainLoopContext> _context) {
+#ifndef WIN32
+    std::lock_guard<std::mutex> itsLock(configurationMutex_);
+    if (configurationWatch_)
+        return false;
+
+    std::unique_ptr<ConfigurationWatch> itsWatch(new ConfigurationWatch(configFile_, [this]() {
+        (void)reloadConfiguration();
+    }));
+    if (!itsWatch->isValid()) {
+        COMMONAPI_ERROR("Cannot watch configuration file \'", configFile_, "\' (", errno, ")");
+        return false;
+    }
+
+    itsWatch->start(_context);
+    configurationWatch_ = std::move(itsWatch);
+    COMMONAPI_INFO("Watching configuration file \'", configFile_, "\'");
+    return true;
+#else
+    (void)_context;
+    return false;
+#endif
+}
+
+void
+Runtime::unwatchConfiguration() {
+    // The watch is destroyed without holding the lock, as this waits for
+    // a running reload to finish.
+    std::unique_ptr<ConfigurationWatch> itsWatch;
+    {
+        std::lock_guard<std::mutex> itsLock(configurationMutex_);
+        itsWatch = std::move(configurationWatch_);
+    }
+}
+
+bool
+Runtime::reloadConfiguration() {
+    std::lock_guard<std::mutex> itsLock(configurationMutex_);
+    COMMONAPI_INFO("Reloading configuration file \'", configFile_, "\'");
+    if (!readConfiguration(true))
+        return false;
+
+    // The new mappings may name libraries that failed before, or the
+    // libraries may have been installed meanwhile.
+    std::lock_guard<std::mutex> itsGuard(loadMutex_);
+    failedLibraries_.clear();
     return true;
 }
 
@@ -93,78 +529,112 @@ Runtime::unregisterFactory(const std::string &_binding) {
  * Private
  */
 void Runtime::init() {
-    static bool isInitialized(false);
+    // Fast path: once initialized, no lock is needed anymore
+    if (isInitialized_.load(std::memory_order_acquire))
+        return;
+
+    bool isPreloading(false);
+    {
 #ifndef WIN32
-    std::lock_guard<std::mutex> itsLock(mutex_);
+        std::lock_guard<std::mutex> itsLock(mutex_);
 #endif
-    if (!isInitialized) {
-        // Determine default configuration file
-        const char *config = getenv("COMMONAPI_CONFIG");
-        if (config) {
-            defaultConfig_ = config;
-        } else {
-            defaultConfig_ = COMMONAPI_DEFAULT_CONFIG_FOLDER;
-            defaultConfig_ += "/";
-            defaultConfig_ += COMMONAPI_DEFAULT_CONFIG_FILE;
-        }
+        if (!isInitialized_.load(std::memory_order_relaxed)) {
+            // Determine default configuration file
+            const char *config = getenv("COMMONAPI_CONFIG");
+            if (config) {
+                defaultConfig_ = config;
+            } else {
+                defaultConfig_ = COMMONAPI_DEFAULT_CONFIG_FOLDER;
+                defaultConfig_ += "/";
+                defaultConfig_ += COMMONAPI_DEFAULT_CONFIG_FILE;
+            }
 
-        // TODO: evaluate return parameter and decide what to do
-        (void)readConfiguration();
+            // TODO: evaluate return parameter and decide what to do
+            (void)readConfiguration(false);
 
-        // Determine default ipc & shared library folder
-        const char *binding = getenv("COMMONAPI_DEFAULT_BINDING");
-        if (binding)
-            defaultBinding_ = binding;
+            // Determine default ipc & shared library folder
+            const char *binding = getenv("COMMONAPI_DEFAULT_BINDING");
+            if (binding)
+                defaultBinding_ = binding;
 
-        const char *folder = getenv("COMMONAPI_DEFAULT_FOLDER");
-        if (folder)
-            defaultFolder_ = folder;
+            const char *folder = getenv("COMMONAPI_DEFAULT_FOLDER");
+            if (folder)
+                defaultFolder_ = folder;
 
-        // Log settings
-        COMMONAPI_INFO("Using default binding \'", defaultBinding_, "\'");
-        COMMONAPI_INFO("Using default shared library folder \'", defaultFolder_, "\'");
-        COMMONAPI_INFO("Using default configuration file \'", defaultConfig_, "\'");
+            // Log settings
+            COMMONAPI_INFO("Using default binding \'", defaultBinding_, "\'");
+            COMMONAPI_INFO("Using default shared library folder \'", defaultFolder_, "\'");
+            COMMONAPI_INFO("Using default configuration file \'", defaultConfig_, "\'");
 
-        isInitialized = true;
+            isPreloading = isPreloadEnabled_;
+            isInitialized_.store(true, std::memory_order_release);
+        }
     }
+
+    // Interface libraries access the runtime while being loaded. Therefore,
+    // preloading must not be done while holding the lock.
+    if (isPreloading)
+        preloadLibraries();
 }
 
 bool
-Runtime::readConfiguration() {
+Runtime::readConfiguration(bool _isReload) {
 #define MAX_PATH_LEN 255
-    std::string config;
-    char currentDirectory[MAX_PATH_LEN];
+    std::string config(defaultConfig_);
+    if (_isReload) {
+        config = configFile_;
+    } else {
+        char currentDirectory[MAX_PATH_LEN];
 #ifdef WIN32
-    if (GetCurrentDirectory(MAX_PATH_LEN, currentDirectory)) {
+        if (GetCurrentDirectory(MAX_PATH_LEN, currentDirectory)) {
 #else
-    if (getcwd(currentDirectory, MAX_PATH_LEN)) {
+        if (getcwd(currentDirectory, MAX_PATH_LEN)) {
 #endif
-        config = currentDirectory;
-        config += "/";
-        config += COMMONAPI_DEFAULT_CONFIG_FILE;
+            config = currentDirectory;
+            config += "/";
+            config += COMMONAPI_DEFAULT_CONFIG_FILE;
 
-        struct stat s;
-        if (stat(config.c_str(), &s) != 0) {
-            config = defaultConfig_;
+            struct stat s;
+            if (stat(config.c_str(), &s) != 0) {
+                config = defaultConfig_;
+            }
         }
+        configFile_ = config;
     }
 
+    // With a configuration cache, the ini file is only parsed after changes
+    std::shared_ptr<const ConfigurationCache> itsCache;
+    const char *cache = getenv("COMMONAPI_CONFIG_CACHE");
+    if (cache)
+        itsCache = ConfigurationCache::open(cache, config);
+
     IniFileReader reader;
-    if (!reader.load(config))
+    if (!itsCache && !reader.scan(config))
         return false;
 
+    auto hasSection = [&](const char *_section) -> bool {
+        if (itsCache)
+            return itsCache->hasSection(_section);
+        return reader.hasSection(_section);
+    };
+    auto getValue = [&](const char *_section, const char *_key) -> std::string {
+        if (itsCache) {
+            StringView itsValue;
+            return (itsCache->find(_section, _key, itsValue) ? itsValue.toString() : std::string());
+        }
+        return reader.getValueView(_section, _key).toString();
+    };
+
     std::string itsConsole("true");
     std::string itsFile;
     std::string itsDlt("false");
     std::string itsLevel("info");
 
-    std::shared_ptr<IniFileReader::Section> section
-        = reader.getSection("logging");
-    if (section) {
-        itsConsole = section->getValue("console");
-        itsFile = section->getValue("file");
-        itsDlt = section->getValue("dlt");
-        itsLevel = section->getValue("level");
+    if (hasSection("logging")) {
+        itsConsole = getValue("logging", "console");
+        itsFile = getValue("logging", "file");
+        itsDlt = getValue("logging", "dlt");
+        itsLevel = getValue("logging", "level");
     }
 
     Logger::init((itsConsole == "true"),
@@ -172,31 +642,34 @@ Runtime::readConfiguration() {
                  (itsDlt == "true"),
                  itsLevel);
 
-    section    = reader.getSection("default");
-    if (section) {
-        std::string binding = section->getValue("binding");
+    if (hasSection("default") && !_isReload) {
+        std::string binding = getValue("default", "binding");
         if ("" != binding)
             defaultBinding_ = binding;
 
-        std::string folder = section->getValue("folder");
+        std::string folder = getValue("default", "folder");
         if ("" != folder)
             defaultFolder_ = folder;
     }
 
-    section = reader.getSection("proxy");
-    if (section) {
-        for (auto m : section->getMappings()) {
-            COMMONAPI_DEBUG("Adding proxy mapping: ", m.first, " --> ", m.second);
-            libraries_[m.first][true] = m.second;
-        }
+    std::shared_ptr<Libraries> itsLibraries = std::make_shared<Libraries>();
+    if (itsCache) {
+        itsLibraries->cache_ = itsCache;
+    } else {
+        reader.forEach("proxy", [&itsLibraries](const StringView &_key, const StringView &_value) {
+            COMMONAPI_DEBUG("Adding proxy mapping: ", _key, " --> ", _value);
+            itsLibraries->mappings_[_key.toString()][true] = _value.toString();
+        });
+
+        reader.forEach("stub", [&itsLibraries](const StringView &_key, const StringView &_value) {
+            COMMONAPI_DEBUG("Adding stub mapping: ", _key, " --> ", _value);
+            itsLibraries->mappings_[_key.toString()][false] = _value.toString();
+        });
     }
+    std::atomic_store(&libraries_, std::shared_ptr<const Libraries>(itsLibraries));
 
-    section = reader.getSection("stub");
-    if (section) {
-        for (auto m : section->getMappings()) {
-            COMMONAPI_DEBUG("Adding stub mapping: ", m.first, " --> ", m.second);
-            libraries_[m.first][false] = m.second;
-        }
+    if (hasSection("preload") && !_isReload) {
+        isPreloadEnabled_ = (getValue("preload", "enabled") == "true");
     }
 
     return true;
@@ -207,16 +680,46 @@ Runtime::createProxy(
         const std::string &_domain, const std::string &_interface, const std::string &_instance,
         const ConnectionId_t &_connectionId) {
 
+    // Reuse a living proxy for the same address and connection, if allowed...
+    std::unique_lock<std::mutex> itsCacheLock(proxiesMutex_);
+    const bool isCaching(isProxyCacheEnabled_);
+    std::pair<Address, ConnectionId_t> key;
+    if (isCaching) {
+        key = std::make_pair(Address(_domain, _interface, _instance), _connectionId);
+        auto foundProxy = proxies_.find(key);
+        if (foundProxy != proxies_.end()) {
+            std::shared_ptr<Proxy> proxy = foundProxy->second.lock();
+            if (proxy)
+                return proxy;
+            proxies_.erase(foundProxy);
+        }
+    }
+    itsCacheLock.unlock();
+
     // Check whether we already know how to create such proxies...
     std::shared_ptr<Proxy> proxy = createProxyHelper(_domain, _interface, _instance, _connectionId, false);
     if (!proxy) {
         // ...it seems do not, lets try to load a library that does...
-        std::lock_guard<std::mutex> itsGuard(loadMutex_);
         std::string library = getLibrary(_domain, _interface, _instance, true);
-        if (loadLibrary(library) || defaultFactory_) {
+        if (loadLibrary(library) || std::atomic_load(&defaultFactory_)) {
             proxy = createProxyHelper(_domain, _interface, _instance, _connectionId, true);
         }
     }
+
+    if (proxy && isCaching) {
+        itsCacheLock.lock();
+        if (isProxyCacheEnabled_) {
+            // Another thread might have been faster, prefer its proxy
+            std::weak_ptr<Proxy> &cached = proxies_[key];
+            std::shared_ptr<Proxy> cachedProxy = cached.lock();
+            if (cachedProxy) {
+                proxy = cachedProxy;
+            } else {
+                cached = proxy;
+                pruneProxies();
+            }
+        }
+    }
     return proxy;
 }
 
@@ -229,15 +732,99 @@ Runtime::createProxy(
     std::shared_ptr<Proxy> proxy = createProxyHelper(_domain, _interface, _instance, _context, false);
     if (!proxy) {
         // ...it seems do not, lets try to load a library that does...
-        std::lock_guard<std::mutex> itsGuard(loadMutex_);
         std::string library = getLibrary(_domain, _interface, _instance, true);
-        if (loadLibrary(library) || defaultFactory_) {
+        if (loadLibrary(library) || std::atomic_load(&defaultFactory_)) {
             proxy = createProxyHelper(_domain, _interface, _instance, _context, true);
         }
     }
     return proxy;
 }
 
+void
+Runtime::createProxyAsync(
+        const std::string &_domain, const std::string &_interface, const std::string &_instance,
+        const ConnectionId_t &_connectionId,
+        std::function<void(std::shared_ptr<Proxy>)> _callback) {
+    std::string itsDomain(_domain), itsInterface(_interface), itsInstance(_instance);
+    ConnectionId_t itsConnectionId(_connectionId);
+    getThreadPool()->post([this, itsDomain, itsInterface, itsInstance, itsConnectionId, _callback]() {
+        _callback(createProxy(itsDomain, itsInterface, itsInstance, itsConnectionId));
+    });
+}
+
+void
+Runtime::createProxyAsync(
+        const std::string &_domain, const std::string &_interface, const std::string &_instance,
+        std::shared_ptr<MainLoopContext> _context,
+        std::function<void(std::shared_ptr<Proxy>)> _callback) {
+    std::string itsDomain(_domain), itsInterface(_interface), itsInstance(_instance);
+    getThreadPool()->post([this, itsDomain, itsInterface, itsInstance, _context, _callback]() {
+        _callback(createProxy(itsDomain, itsInterface, itsInstance, _context));
+    });
+}
+
+std::vector<std::shared_ptr<Proxy>>
+Runtime::createProxies(
+        const std::string &_domain, const std::string &_interface,
+        const std::vector<std::string> &_instances,
+        const ConnectionId_t &_connectionId) {
+
+    // Load all libraries that are needed in advance, each one only once. This
+    // way, the parallel builds below do not all try to load them.
+    std::set<std::string> itsLibraries;
+    for (auto &instance : _instances)
+        itsLibraries.insert(getLibrary(_domain, _interface, instance, true));
+    for (auto &library : itsLibraries)
+        (void)loadLibrary(library);
+
+    // Workers and the calling thread take instances from a shared index
+    // until all are done. If all workers are busy, the calling thread
+    // builds the proxies on its own.
+    struct Batch {
+        Batch(std::size_t _size)
+            : next_(0), done_(0), proxies_(_size) {}
+
+        std::atomic<std::size_t> next_;
+        std::size_t done_;
+        std::vector<std::shared_ptr<Proxy>> proxies_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+    };
+
+    std::shared_ptr<Batch> itsBatch = std::make_shared<Batch>(_instances.size());
+    std::shared_ptr<std::vector<std::string>> itsInstances
+        = std::make_shared<std::vector<std::string>>(_instances);
+    std::string itsDomain(_domain), itsInterface(_interface);
+    ConnectionId_t itsConnectionId(_connectionId);
+
+    auto build = [this, itsBatch, itsInstances, itsDomain, itsInterface, itsConnectionId]() {
+        std::size_t index;
+        while ((index = itsBatch->next_.fetch_add(1)) < itsInstances->size()) {
+            std::shared_ptr<Proxy> proxy
+                = createProxy(itsDomain, itsInterface, (*itsInstances)[index], itsConnectionId);
+
+            std::lock_guard<std::mutex> itsLock(itsBatch->mutex_);
+            itsBatch->proxies_[index] = proxy;
+            if (++itsBatch->done_ == itsInstances->size())
+                itsBatch->condition_.notify_all();
+        }
+    };
+
+    if (_instances.size() > 1) {
+        std::shared_ptr<ThreadPool> itsPool = getThreadPool();
+        std::size_t itsHelpers = std::min(itsPool->getThreadCount(), _instances.size() - 1);
+        for (std::size_t i = 0; i < itsHelpers; i++)
+            itsPool->post(build);
+    }
+    build();
+
+    std::unique_lock<std::mutex> itsLock(itsBatch->mutex_);
+    itsBatch->condition_.wait(itsLock, [&itsBatch, &_instances]() {
+        return (itsBatch->done_ == _instances.size());
+    });
+    return itsBatch->proxies_;
+}
+
 
 bool
 Runtime::registerStub(const std::string &_domain, const std::string &_interface, const std::string &_instance,
@@ -246,11 +833,20 @@ Runtime::registerStub(const std::string &_domain, const std::string &_interface,
     bool isRegistered = registerStubHelper(_domain, _interface, _instance, _stub, _connectionId, false);
     if (!isRegistered) {
         std::string library = getLibrary(_domain, _interface, _instance, false);
-        std::lock_guard<std::mutex> itsGuard(loadMutex_);
-        if (loadLibrary(library) || defaultFactory_) {
+        if (loadLibrary(library) || std::atomic_load(&defaultFactory_)) {
             isRegistered = registerStubHelper(_domain, _interface, _instance, _stub, _connectionId, true);
         }
     }
+
+    // Make the stub available to local proxies as well. This is additive,
+    // the result is the one of the binding unless the in-process binding is
+    // the default one.
+    Factory *local = localFactory_.load(std::memory_order_acquire);
+    if (local && (isRegistered || defaultBinding_ == LOCAL_BINDING)) {
+        if (local->registerStub(_domain, _interface, _instance, _stub, _connectionId))
+            isRegistered = true;
+    }
+
     return isRegistered;
 }
 
@@ -261,22 +857,42 @@ Runtime::registerStub(const std::string &_domain, const std::string &_interface,
     bool isRegistered = registerStubHelper(_domain, _interface, _instance, _stub, _context, false);
     if (!isRegistered) {
         std::string library = getLibrary(_domain, _interface, _instance, false);
-        std::lock_guard<std::mutex> itsGuard(loadMutex_);
-        if (loadLibrary(library) || defaultFactory_) {
+        if (loadLibrary(library) || std::atomic_load(&defaultFactory_)) {
             isRegistered = registerStubHelper(_domain, _interface, _instance, _stub, _context, true);
         }
     }
+
+    // Make the stub available to local proxies as well. This is additive,
+    // the result is the one of the binding unless the in-process binding is
+    // the default one.
+    Factory *local = localFactory_.load(std::memory_order_acquire);
+    if (local && (isRegistered || defaultBinding_ == LOCAL_BINDING)) {
+        if (local->registerStub(_domain, _interface, _instance, _stub, _context))
+            isRegistered = true;
+    }
+
     return isRegistered;
 }
 
 bool
 Runtime::unregisterStub(const std::string &_domain, const std::string &_interface, const std::string &_instance) {
-    for (auto factory : factories_) {
-        if (factory.second->unregisterStub(_domain, _interface, _instance))
-            return true;
+    Factory *local = localFactory_.load(std::memory_order_acquire);
+    bool isUnregistered = (local && local->unregisterStub(_domain, _interface, _instance)
+                           && defaultBinding_ == LOCAL_BINDING);
+
+    {
+        std::lock_guard<std::mutex> itsLock(factoriesMutex_);
+        for (auto &factory : factories_) {
+            if (factory.second->unregisterStub(_domain, _interface, _instance))
+                return true;
+        }
     }
 
-    return (defaultFactory_ ? defaultFactory_->unregisterStub(_domain, _interface, _instance) : false);
+    std::shared_ptr<Factory> itsDefault = std::atomic_load(&defaultFactory_);
+    if (itsDefault && itsDefault->unregisterStub(_domain, _interface, _instance))
+        return true;
+
+    return isUnregistered;
 }
 
 std::string
@@ -289,12 +905,19 @@ Runtime::getLibrary(
 
     COMMONAPI_DEBUG("Loading library for ", address, (_isProxy ? " proxy." : " stub."));
 
-    auto libraryIterator = libraries_.find(address);
-    if (libraryIterator != libraries_.end()) {
-        auto addressIterator = libraryIterator->second.find(_isProxy);
-        if (addressIterator != libraryIterator->second.end()) {
-            library = addressIterator->second;
-            return library;
+    std::shared_ptr<const Libraries> itsLibraries = std::atomic_load(&libraries_);
+    if (itsLibraries->cache_) {
+        StringView itsLibrary;
+        if (itsLibraries->cache_->find((_isProxy ? "proxy" : "stub"), address, itsLibrary))
+            return itsLibrary.toString();
+    } else {
+        auto libraryIterator = itsLibraries->mappings_.find(address);
+        if (libraryIterator != itsLibraries->mappings_.end()) {
+            auto addressIterator = libraryIterator->second.find(_isProxy);
+            if (addressIterator != libraryIterator->second.end()) {
+                library = addressIterator->second;
+                return library;
+            }
         }
     }
 
@@ -331,88 +954,261 @@ Runtime::loadLibrary(const std::string &_library) {
     }
     #endif
 
+    // Do not retry libraries that are already loaded or failed to load. Only
+    // the bookkeeping is done under loadMutex_, loading a library twice in
+    // parallel is harmless.
+    {
+        std::lock_guard<std::mutex> itsGuard(loadMutex_);
+        if (loadedLibraries_.end() != loadedLibraries_.find(itsLibrary))
+            return true;
+        if (failedLibraries_.end() != failedLibraries_.find(itsLibrary))
+            return false;
+    }
+
     bool isLoaded(true);
-    if (loadedLibraries_.end() == loadedLibraries_.find(itsLibrary)) {
-        #ifdef WIN32
-        if (LoadLibrary(itsLibrary.c_str()) != 0) {
-            loadedLibraries_.insert(itsLibrary);
-            COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" succeeded.");
-        } else {
-            COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" failed (", GetLastError(), ")");
-            isLoaded = false;
-        }
-        #else
-        if (dlopen(itsLibrary.c_str(), RTLD_LAZY | RTLD_GLOBAL) != 0) {
-            loadedLibraries_.insert(itsLibrary);
-            COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" succeeded.");
-        }
-        else {
-            COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" failed (", dlerror(), ")");
-            isLoaded = false;
-        }
-        #endif
+    #ifdef WIN32
+    if (LoadLibrary(itsLibrary.c_str()) != 0) {
+        COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" succeeded.");
+    } else {
+        COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" failed (", GetLastError(), ")");
+        isLoaded = false;
+    }
+    #else
+    if (dlopen(itsLibrary.c_str(), RTLD_LAZY | RTLD_GLOBAL) != 0) {
+        COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" succeeded.");
+    }
+    else {
+        COMMONAPI_DEBUG("Loading interface library \"", itsLibrary, "\" failed (", dlerror(), ")");
+        isLoaded = false;
+    }
+    #endif
+
+    std::lock_guard<std::mutex> itsGuard(loadMutex_);
+    if (isLoaded) {
+        loadedLibraries_.insert(itsLibrary);
+    } else {
+        failedLibraries_.insert(itsLibrary);
     }
     return isLoaded;
 }
 
+void
+Runtime::preloadLibraries() {
+    std::shared_ptr<const Libraries> itsMappings = std::atomic_load(&libraries_);
+    std::set<std::string> itsLibraries;
+    if (itsMappings->cache_) {
+        auto itsHandler = [&itsLibraries](const StringView &, const StringView &_library) {
+            itsLibraries.insert(_library.toString());
+        };
+        itsMappings->cache_->forEach("proxy", itsHandler);
+        itsMappings->cache_->forEach("stub", itsHandler);
+    } else {
+        for (auto &address : itsMappings->mappings_) {
+            for (auto &library : address.second)
+                itsLibraries.insert(library.second);
+        }
+    }
+
+    COMMONAPI_INFO("Preloading ", itsLibraries.size(), " interface libraries");
+
+    // The libraries are loaded in the background. Waiting for them here
+    // could deadlock if the runtime is first used while the dynamic loader
+    // holds its lock, e.g. from a static constructor of a library.
+    std::shared_ptr<ThreadPool> itsPool = getThreadPool();
+    for (auto &library : itsLibraries) {
+        itsPool->post([this, library]() {
+            (void)loadLibrary(library);
+        });
+    }
+}
+
 std::shared_ptr<Proxy>
 Runtime::createProxyHelper(const std::string &_domain, const std::string &_interface, const std::string &_instance,
                            const std::string &_connectionId, bool _useDefault) {
+    Factory *local = localFactory_.load(std::memory_order_acquire);
+    if (local) {
+        std::shared_ptr<Proxy> proxy
+            = local->createProxy(_domain, _interface, _instance, _connectionId);
+        if (proxy)
+            return proxy;
+    }
+
+    // A route may lead to the default factory, only used with _useDefault
+    std::shared_ptr<Factory> itsDefault = std::atomic_load(&defaultFactory_);
+    std::shared_ptr<Factory> routed = getRoute(_domain, _interface, _connectionId, true);
+    if (routed && (routed != itsDefault || _useDefault)) {
+        std::shared_ptr<Proxy> proxy
+            = routed->createProxy(_domain, _interface, _instance, _connectionId);
+        if (proxy)
+            return proxy;
+    }
+
+    // Routes do not include the instance, other factories might serve it
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
-    for (auto factory : factories_) {
+    for (auto &factory : factories_) {
+        if (factory.second == routed)
+            continue;
         std::shared_ptr<Proxy> proxy
             = factory.second->createProxy(_domain, _interface, _instance, _connectionId);
-        if (proxy)
+        if (proxy) {
+            addRoute(_domain, _interface, _connectionId, true, factory.second);
             return proxy;
+        }
+    }
+    if (_useDefault && itsDefault && itsDefault != routed) {
+        std::shared_ptr<Proxy> proxy
+            = itsDefault->createProxy(_domain, _interface, _instance, _connectionId);
+        if (proxy)
+            addRoute(_domain, _interface, _connectionId, true, itsDefault);
+        return proxy;
     }
-    return (_useDefault && defaultFactory_ ?
-                defaultFactory_->createProxy(_domain, _interface, _instance, _connectionId)
-                : nullptr);
+    return nullptr;
 }
 
 std::shared_ptr<Proxy>
 Runtime::createProxyHelper(const std::string &_domain, const std::string &_interface, const std::string &_instance,
                            std::shared_ptr<MainLoopContext> _context, bool _useDefault) {
+    Factory *local = localFactory_.load(std::memory_order_acquire);
+    if (local) {
+        std::shared_ptr<Proxy> proxy
+            = local->createProxy(_domain, _interface, _instance, _context);
+        if (proxy)
+            return proxy;
+    }
+
+    const std::string &itsConnection = (_context ? _context->getName() : DEFAULT_CONNECTION_ID);
+    // A route may lead to the default factory, only used with _useDefault
+    std::shared_ptr<Factory> itsDefault = std::atomic_load(&defaultFactory_);
+    std::shared_ptr<Factory> routed = getRoute(_domain, _interface, itsConnection, true);
+    if (routed && (routed != itsDefault || _useDefault)) {
+        std::shared_ptr<Proxy> proxy
+            = routed->createProxy(_domain, _interface, _instance, _context);
+        if (proxy)
+            return proxy;
+    }
+
+    // Routes do not include the instance, other factories might serve it
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
-    for (auto factory : factories_) {
+    for (auto &factory : factories_) {
+        if (factory.second == routed)
+            continue;
         std::shared_ptr<Proxy> proxy
             = factory.second->createProxy(_domain, _interface, _instance, _context);
-        if (proxy)
+        if (proxy) {
+            addRoute(_domain, _interface, itsConnection, true, factory.second);
             return proxy;
+        }
+    }
+    if (_useDefault && itsDefault && itsDefault != routed) {
+        std::shared_ptr<Proxy> proxy
+            = itsDefault->createProxy(_domain, _interface, _instance, _context);
+        if (proxy)
+            addRoute(_domain, _interface, itsConnection, true, itsDefault);
+        return proxy;
     }
-    return (_useDefault && defaultFactory_ ?
-                defaultFactory_->createProxy(_domain, _interface, _instance, _context) :
-                nullptr);
+    return nullptr;
 }
 
 bool
 Runtime::registerStubHelper(const std::string &_domain, const std::string &_interface, const std::string &_instance,
                             std::shared_ptr<StubBase> _stub, const std::string &_connectionId, bool _useDefault) {
-    bool isRegistered(false);
+    // A route may lead to the default factory, only used with _useDefault
+    std::shared_ptr<Factory> itsDefault = std::atomic_load(&defaultFactory_);
+    std::shared_ptr<Factory> routed = getRoute(_domain, _interface, _connectionId, false);
+    if (routed && (routed != itsDefault || _useDefault)
+            && routed->registerStub(_domain, _interface, _instance, _stub, _connectionId))
+        return true;
+
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
-    for (auto factory : factories_) {
-        isRegistered = factory.second->registerStub(_domain, _interface, _instance, _stub, _connectionId);
-        if (isRegistered)
-            return isRegistered;
+    for (auto &factory : factories_) {
+        if (factory.second != routed
+                && factory.second->registerStub(_domain, _interface, _instance, _stub, _connectionId)) {
+            addRoute(_domain, _interface, _connectionId, false, factory.second);
+            return true;
+        }
+    }
+    if (_useDefault && itsDefault && itsDefault != routed
+            && itsDefault->registerStub(_domain, _interface, _instance, _stub, _connectionId)) {
+        addRoute(_domain, _interface, _connectionId, false, itsDefault);
+        return true;
     }
-    return (_useDefault && defaultFactory_ ?
-                defaultFactory_->registerStub(_domain, _interface, _instance, _stub, _connectionId) :
-                false);
+    return false;
 }
 
 bool
 Runtime::registerStubHelper(const std::string &_domain, const std::string &_interface, const std::string &_instance,
                             std::shared_ptr<StubBase> _stub, std::shared_ptr<MainLoopContext> _context, bool _useDefault) {
-    bool isRegistered(false);
+    const std::string &itsConnection = (_context ? _context->getName() : DEFAULT_CONNECTION_ID);
+    // A route may lead to the default factory, only used with _useDefault
+    std::shared_ptr<Factory> itsDefault = std::atomic_load(&defaultFactory_);
+    std::shared_ptr<Factory> routed = getRoute(_domain, _interface, itsConnection, false);
+    if (routed && (routed != itsDefault || _useDefault)
+            && routed->registerStub(_domain, _interface, _instance, _stub, _context))
+        return true;
+
     std::lock_guard<std::mutex> itsLock(factoriesMutex_);
-    for (auto factory : factories_) {
-        isRegistered = factory.second->registerStub(_domain, _interface, _instance, _stub, _context);
-        if (isRegistered)
-            return isRegistered;
-    }
-    return (_useDefault && defaultFactory_ ?
-                defaultFactory_->registerStub(_domain, _interface, _instance, _stub, _context) :
-                false);
+    for (auto &factory : factories_) {
+        if (factory.second != routed
+                && factory.second->registerStub(_domain, _interface, _instance, _stub, _context)) {
+            addRoute(_domain, _interface, itsConnection, false, factory.second);
+            return true;
+        }
+    }
+    if (_useDefault && itsDefault && itsDefault != routed
+            && itsDefault->registerStub(_domain, _interface, _instance, _stub, _context)) {
+        addRoute(_domain, _interface, itsConnection, false, itsDefault);
+        return true;
+    }
+    return false;
+}
+
+// The tables are shared pointers, loaded and replaced by std::atomic_load
+// and std::atomic_store. These are not lock-free, libstdc++ guards them by
+// a small pool of mutexes, but a reader never waits for a writer holding
+// routesMutex_. A reader keeps the table and the factory it found alive
+// while it uses them, a replaced table is freed with the last reader.
+std::shared_ptr<Factory>
+Runtime::getRoute(const std::string &_domain, const std::string &_interface,
+                  const std::string &_connection, bool _isProxy) const {
+    std::shared_ptr<RoutingTable> itsRoutes
+        = std::atomic_load(_isProxy ? &proxyRoutes_ : &stubRoutes_);
+    return itsRoutes->find(RoutingTable::hash(_domain, _interface, _connection),
+                           _domain, _interface, _connection);
+}
+
+void
+Runtime::addRoute(const std::string &_domain, const std::string &_interface,
+                  const std::string &_connection, bool _isProxy,
+                  const std::shared_ptr<Factory> &_factory) {
+    std::lock_guard<std::mutex> itsLock(routesMutex_);
+    std::shared_ptr<RoutingTable> *itsRoutes = (_isProxy ? &proxyRoutes_ : &stubRoutes_);
+    std::shared_ptr<RoutingTable> current = std::atomic_load(itsRoutes);
+
+    const std::size_t itsHash = RoutingTable::hash(_domain, _interface, _connection);
+    if (current->find(itsHash, _domain, _interface, _connection))
+        return;
+
+    if (!current->insert(itsHash, _domain, _interface, _connection, _factory)) {
+        // Table is full: publish a copy with doubled capacity
+        std::shared_ptr<RoutingTable> itsCopy
+            = std::make_shared<RoutingTable>(current->getCapacity() * 2);
+        for (std::size_t i = 0; i < current->getSize(); i++) {
+            const RoutingTable::Route &route = current->getRoute(i);
+            itsCopy->insert(route.hash_, route.domain_, route.interface_,
+                            route.connection_, route.factory_);
+        }
+        itsCopy->insert(itsHash, _domain, _interface, _connection, _factory);
+        std::atomic_store(itsRoutes, itsCopy);
+    }
+}
+
+void
+Runtime::clearRoutes() {
+    std::lock_guard<std::mutex> itsLock(routesMutex_);
+    std::atomic_store(&proxyRoutes_,
+                      std::make_shared<RoutingTable>(ROUTING_TABLE_INITIAL_CAPACITY));
+    std::atomic_store(&stubRoutes_,
+                      std::make_shared<RoutingTable>(ROUTING_TABLE_INITIAL_CAPACITY));
 }
 
 } //Namespace CommonAPI
@@ -0,0 +1,270 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WIN32
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <CommonAPI/Logger.hpp>
+#include <CommonAPI/ShmChannel.hpp>
+
+namespace CommonAPI {
+
+ShmWatch::ShmWatch(int _fd, std::function<void(unsigned int)> _callback)
+    : callback_(_callback) {
+    pollFd_.fd = _fd;
+    pollFd_.events = POLLIN;
+    pollFd_.revents = 0;
+}
+
+ShmWatch::~ShmWatch() {
+}
+
+void
+ShmWatch::dispatch(unsigned int _eventFlags) {
+    // The callback might destroy this watch
+    std::function<void(unsigned int)> itsCallback(callback_);
+    itsCallback(_eventFlags);
+}
+
+const pollfd &
+ShmWatch::getAssociatedFileDescriptor() {
+    return pollFd_;
+}
+
+const std::vector<DispatchSource *> &
+ShmWatch::getDependentDispatchSources() {
+    return dependentSources_;
+}
+
+const std::size_t ShmChannel::FILE_DESCRIPTORS;
+
+std::shared_ptr<ShmChannel>
+ShmChannel::create(const std::string &_name, std::size_t _capacity) {
+    std::shared_ptr<ShmRingBuffer> itsOutgoing = ShmRingBuffer::create(_name + "-out", _capacity);
+    std::shared_ptr<ShmRingBuffer> itsIncoming = ShmRingBuffer::create(_name + "-in", _capacity);
+    if (!itsOutgoing || !itsIncoming)
+        return nullptr;
+
+    // Notify and wait for messages, notify and wait for released messages
+    int itsFds[4];
+    for (std::size_t i = 0; i < 4; i++) {
+        itsFds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (itsFds[i] < 0) {
+            COMMONAPI_ERROR("ShmChannel: cannot create eventfd (", errno, ")");
+            while (i > 0)
+                close(itsFds[--i]);
+            return nullptr;
+        }
+    }
+
+    return std::shared_ptr<ShmChannel>(
+                new ShmChannel(itsOutgoing, itsIncoming, itsFds[0], itsFds[1], itsFds[2], itsFds[3]));
+}
+
+std::shared_ptr<ShmChannel>
+ShmChannel::attach(const std::vector<int> &_fds, int _connection) {
+    if (_fds.size() != FILE_DESCRIPTORS) {
+        for (auto fd : _fds)
+            close(fd);
+        if (_connection >= 0)
+            close(_connection);
+        return nullptr;
+    }
+
+    std::shared_ptr<ShmRingBuffer> itsOutgoing = ShmRingBuffer::attach(_fds[0]);
+    std::shared_ptr<ShmRingBuffer> itsIncoming = ShmRingBuffer::attach(_fds[1]);
+    if (!itsOutgoing || !itsIncoming) {
+        for (std::size_t i = 2; i < FILE_DESCRIPTORS; i++)
+            close(_fds[i]);
+        if (_connection >= 0)
+            close(_connection);
+        return nullptr;
+    }
+
+    std::shared_ptr<ShmChannel> itsChannel(
+                new ShmChannel(itsOutgoing, itsIncoming, _fds[2], _fds[3], _fds[4], _fds[5]));
+    itsChannel->connection_ = _connection;
+    return itsChannel;
+}
+
+ShmChannel::ShmChannel(std::shared_ptr<ShmRingBuffer> _outgoing, std::shared_ptr<ShmRingBuffer> _incoming,
+                       int _notifyFd, int _waitFd, int _releaseNotifyFd, int _releaseWaitFd)
+    : outgoing_(_outgoing),
+      incoming_(_incoming),
+      notifyFd_(_notifyFd),
+      waitFd_(_waitFd),
+      releaseNotifyFd_(_releaseNotifyFd),
+      releaseWaitFd_(_releaseWaitFd),
+      connection_(-1),
+      sendTimeout_(DEFAULT_SEND_TIMEOUT_MS) {
+}
+
+ShmChannel::~ShmChannel() {
+    if (context_ && watch_)
+        context_->deregisterWatch(watch_.get());
+    close(notifyFd_);
+    close(waitFd_);
+    close(releaseNotifyFd_);
+    close(releaseWaitFd_);
+    if (connection_ >= 0)
+        close(connection_);
+}
+
+std::vector<int>
+ShmChannel::getPeerFileDescriptors() const {
+    // The peer writes where we read and vice versa
+    std::vector<int> itsFds(FILE_DESCRIPTORS);
+    itsFds[0] = incoming_->getFileDescriptor();
+    itsFds[1] = outgoing_->getFileDescriptor();
+    itsFds[2] = waitFd_;
+    itsFds[3] = notifyFd_;
+    itsFds[4] = releaseWaitFd_;
+    itsFds[5] = releaseNotifyFd_;
+    return itsFds;
+}
+
+bool
+ShmChannel::send(const MessageWriter &_writer, std::size_t _size) {
+    std::lock_guard<std::mutex> itsLock(sendMutex_);
+
+    if (_size > outgoing_->getMaximumMessageSize()) {
+        COMMONAPI_WARNING("ShmChannel: message exceeds the maximum message size");
+        return false;
+    }
+
+    const Timeout_t itsTimeout = sendTimeout_.load(std::memory_order_relaxed);
+    const std::chrono::steady_clock::time_point itsDeadline
+        = std::chrono::steady_clock::now() + std::chrono::milliseconds(itsTimeout > 0 ? itsTimeout : 0);
+
+    // Without a size hint the message is written to the contiguous free
+    // space. If it does not fit, the reservation is retried with a larger
+    // size, which skips the end of the buffer.
+    std::size_t itsSize(_size);
+    for (;;) {
+        std::size_t itsAvailable(0);
+        uint8_t *itsData = outgoing_->reserve(itsSize, itsAvailable);
+        if (!itsData) {
+            if (!waitForRelease(itsTimeout, itsDeadline)) {
+                COMMONAPI_WARNING("ShmChannel: no space left to send message, receiver is not reading");
+                return false;
+            }
+            continue;
+        }
+
+        MemoryOutputStream itsStream(itsData, itsAvailable);
+        _writer(itsStream);
+        if (!itsStream.hasError()) {
+            outgoing_->commit(itsStream.getSize());
+            break;
+        }
+
+        if (itsAvailable >= outgoing_->getMaximumMessageSize()) {
+            COMMONAPI_WARNING("ShmChannel: message exceeds the maximum message size");
+            return false;
+        }
+        itsSize = itsAvailable + 1;
+    }
+
+    if (eventfd_write(notifyFd_, 1) != 0) {
+        COMMONAPI_ERROR("ShmChannel: cannot notify peer (", errno, ")");
+    }
+    return true;
+}
+
+void
+ShmChannel::setSendTimeout(Timeout_t _timeout) {
+    sendTimeout_.store(_timeout, std::memory_order_relaxed);
+}
+
+// Waits until the receiver released messages. Pending notifications are
+// consumed before the caller checks for space again, a release afterwards
+// is therefore not missed. Returns false once the deadline passed.
+bool
+ShmChannel::waitForRelease(Timeout_t _timeout,
+                           const std::chrono::steady_clock::time_point &_deadline) {
+    eventfd_t itsValue;
+    if (eventfd_read(releaseWaitFd_, &itsValue) == 0)
+        return true;
+
+    int itsWait(-1);
+    if (_timeout >= 0) {
+        auto itsLeft = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    _deadline - std::chrono::steady_clock::now()).count();
+        if (itsLeft <= 0)
+            return false;
+        itsWait = int(itsLeft);
+    }
+
+    pollfd itsPollFd;
+    itsPollFd.fd = releaseWaitFd_;
+    itsPollFd.events = POLLIN;
+    itsPollFd.revents = 0;
+    if (poll(&itsPollFd, 1, itsWait) < 0 && errno != EINTR) {
+        COMMONAPI_ERROR("ShmChannel: cannot wait for receiver (", errno, ")");
+        return false;
+    }
+    return true;
+}
+
+void
+ShmChannel::setMessageHandler(MessageHandler _handler) {
+    std::lock_guard<std::recursive_mutex> itsLock(dispatchMutex_);
+    handler_ = _handler;
+}
+
+std::size_t
+ShmChannel::dispatch() {
+    std::lock_guard<std::recursive_mutex> itsLock(dispatchMutex_);
+
+    eventfd_t itsValue;
+    (void)eventfd_read(waitFd_, &itsValue);
+
+    // The handler might replace itself
+    MessageHandler itsHandler(handler_);
+
+    std::size_t itsCount(0);
+    const uint8_t *itsData;
+    std::size_t itsSize;
+    while (incoming_->peek(itsData, itsSize)) {
+        if (itsHandler) {
+            MemoryInputStream itsStream(itsData, itsSize);
+            itsHandler(itsStream);
+        }
+        incoming_->release();
+        itsCount++;
+    }
+
+    // Wake up a sender waiting for space
+    if (itsCount > 0 && eventfd_write(releaseNotifyFd_, 1) != 0) {
+        COMMONAPI_ERROR("ShmChannel: cannot notify peer (", errno, ")");
+    }
+    return itsCount;
+}
+
+void
+ShmChannel::registerWatch(std::shared_ptr<MainLoopContext> _context, DispatchPriority _priority) {
+    if (context_ && watch_)
+        context_->deregisterWatch(watch_.get());
+
+    context_ = _context;
+    std::weak_ptr<ShmChannel> itsChannel(shared_from_this());
+    watch_ = std::unique_ptr<ShmWatch>(new ShmWatch(waitFd_, [itsChannel](unsigned int) {
+        std::shared_ptr<ShmChannel> itsLockedChannel = itsChannel.lock();
+        if (itsLockedChannel)
+            (void)itsLockedChannel->dispatch();
+    }));
+    if (context_)
+        context_->registerWatch(watch_.get(), _priority);
+}
+
+} // namespace CommonAPI
+
+#endif // !WIN32
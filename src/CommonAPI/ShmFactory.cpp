@@ -0,0 +1,655 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WIN32
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <CommonAPI/Logger.hpp>
+#include <CommonAPI/ShmFactory.hpp>
+
+namespace CommonAPI {
+
+static const std::size_t SHM_DEFAULT_CHANNEL_CAPACITY = 1024 * 1024;
+static const std::chrono::milliseconds SHM_DEFAULT_CONNECT_TIMEOUT(250);
+static const int SHM_LISTEN_BACKLOG = 16;
+
+// Both sides start with a hello naming the full address, the socket name is
+// only a hash of it.
+static const uint32_t SHM_HELLO_MAGIC = 0x43415049; // "CAPI"
+static const uint32_t SHM_PROTOCOL_VERSION = 1;
+static const uint32_t SHM_MAX_ADDRESS_LENGTH = 4096;
+
+struct ShmHello {
+    uint32_t magic_;
+    uint32_t version_;
+    uint32_t length_;
+};
+
+/**
+ * Minimal main loop dispatching the watches of channels that were created
+ * for a connection id instead of a MainLoopContext. The loop may be
+ * destroyed from its own thread, e.g. by a callback releasing the last
+ * reference to the factory. Therefore, the thread owns the state it uses.
+ */
+class ShmMainLoop {
+public:
+    ShmMainLoop()
+        : state_(std::make_shared<State>()) {
+        State *itsState = state_.get();
+        subscription_ = state_->context_->subscribeForWatches(
+            [itsState](Watch *_watch, const DispatchPriority) {
+                std::lock_guard<std::recursive_mutex> itsLock(itsState->mutex_);
+                itsState->watches_.push_back(_watch);
+                itsState->wakeup();
+            },
+            [itsState](Watch *_watch) {
+                std::lock_guard<std::recursive_mutex> itsLock(itsState->mutex_);
+                itsState->watches_.erase(std::remove(itsState->watches_.begin(),
+                                                     itsState->watches_.end(), _watch),
+                                         itsState->watches_.end());
+                itsState->wakeup();
+            });
+        thread_ = std::thread(&ShmMainLoop::run, state_);
+    }
+
+    ~ShmMainLoop() {
+        state_->context_->unsubscribeForWatches(subscription_);
+        {
+            // Watches may outlive the loop, they must not be dispatched
+            // by a detached thread anymore.
+            std::lock_guard<std::recursive_mutex> itsLock(state_->mutex_);
+            state_->watches_.clear();
+        }
+        state_->isRunning_ = false;
+        state_->wakeup();
+        if (thread_.get_id() == std::this_thread::get_id()) {
+            thread_.detach();
+        } else {
+            thread_.join();
+        }
+    }
+
+    const std::shared_ptr<MainLoopContext> &getContext() const {
+        return state_->context_;
+    }
+
+private:
+    struct State {
+        State()
+            : context_(std::make_shared<MainLoopContext>("CommonAPI-shm")),
+              wakeupFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+              isRunning_(true) {
+        }
+
+        ~State() {
+            close(wakeupFd_);
+        }
+
+        void wakeup() {
+            (void)eventfd_write(wakeupFd_, 1);
+        }
+
+        std::shared_ptr<MainLoopContext> context_;
+        std::vector<Watch *> watches_;
+        std::recursive_mutex mutex_;
+
+        int wakeupFd_;
+        std::atomic<bool> isRunning_;
+    };
+
+    static void run(std::shared_ptr<State> _state) {
+        std::vector<Watch *> itsWatches;
+        std::vector<pollfd> itsFds;
+        while (_state->isRunning_) {
+            itsFds.clear();
+            pollfd itsWakeup;
+            itsWakeup.fd = _state->wakeupFd_;
+            itsWakeup.events = POLLIN;
+            itsWakeup.revents = 0;
+            itsFds.push_back(itsWakeup);
+            {
+                std::lock_guard<std::recursive_mutex> itsLock(_state->mutex_);
+                itsWatches = _state->watches_;
+                for (auto watch : itsWatches)
+                    itsFds.push_back(watch->getAssociatedFileDescriptor());
+            }
+
+            if (poll(&itsFds[0], itsFds.size(), -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                COMMONAPI_ERROR("ShmMainLoop: poll failed (", errno, ")");
+                break;
+            }
+
+            if (itsFds[0].revents) {
+                eventfd_t itsValue;
+                (void)eventfd_read(_state->wakeupFd_, &itsValue);
+            }
+
+            for (std::size_t i = 1; i < itsFds.size(); i++) {
+                if (0 == itsFds[i].revents)
+                    continue;
+
+                // Dispatch only watches that were not removed meanwhile
+                std::lock_guard<std::recursive_mutex> itsLock(_state->mutex_);
+                Watch *itsWatch = itsWatches[i-1];
+                if (std::find(_state->watches_.begin(), _state->watches_.end(), itsWatch)
+                        != _state->watches_.end())
+                    itsWatch->dispatch(itsFds[i].revents);
+            }
+        }
+    }
+
+    std::shared_ptr<State> state_;
+    WatchListenerSubscription subscription_;
+    std::thread thread_;
+};
+
+/*
+ * Helpers
+ */
+static socklen_t
+getSocketAddress(const Address &_address, sockaddr_un &_socketAddress) {
+    // Abstract socket names are limited, therefore the address is hashed
+    std::stringstream itsName;
+    itsName << "CommonAPI-shm-" << std::hex << _address.getHash();
+    std::string itsPath(itsName.str());
+
+    std::memset(&_socketAddress, 0, sizeof(_socketAddress));
+    _socketAddress.sun_family = AF_UNIX;
+    std::memcpy(_socketAddress.sun_path + 1, itsPath.data(), itsPath.size());
+    return socklen_t(offsetof(sockaddr_un, sun_path) + 1 + itsPath.size());
+}
+
+static std::string
+getHello(const Address &_address) {
+    std::string itsAddress(_address.getAddressRef());
+    ShmHello itsHello;
+    itsHello.magic_ = SHM_HELLO_MAGIC;
+    itsHello.version_ = SHM_PROTOCOL_VERSION;
+    itsHello.length_ = uint32_t(itsAddress.size());
+
+    std::string itsData(reinterpret_cast<const char *>(&itsHello), sizeof(itsHello));
+    itsData += itsAddress;
+    return itsData;
+}
+
+/*
+ * Returns the size of the hello at the start of the given data, 0 if it is
+ * incomplete or -1 if it is invalid or names a different address.
+ */
+static ssize_t
+checkHello(const std::string &_data, const Address &_address) {
+    if (_data.size() < sizeof(ShmHello))
+        return 0;
+
+    ShmHello itsHello;
+    std::memcpy(&itsHello, _data.data(), sizeof(itsHello));
+    if (itsHello.magic_ != SHM_HELLO_MAGIC
+            || itsHello.version_ != SHM_PROTOCOL_VERSION
+            || itsHello.length_ > SHM_MAX_ADDRESS_LENGTH)
+        return -1;
+
+    std::size_t itsSize = sizeof(itsHello) + itsHello.length_;
+    if (_data.size() < itsSize)
+        return 0;
+    if (_data.compare(sizeof(itsHello), itsHello.length_, _address.getAddressRef()) != 0)
+        return -1;
+    return ssize_t(itsSize);
+}
+
+/*
+ * Only processes of the same user, or of root, may connect to each other.
+ * Anybody can bind an abstract socket name.
+ */
+static bool
+isTrustedPeer(int _socket) {
+    ucred itsCredentials;
+    socklen_t itsLength = sizeof(itsCredentials);
+    if (getsockopt(_socket, SOL_SOCKET, SO_PEERCRED, &itsCredentials, &itsLength) != 0)
+        return false;
+    return (itsCredentials.uid == geteuid() || itsCredentials.uid == 0);
+}
+
+static bool
+sendFileDescriptors(int _socket, const std::vector<int> &_fds, const std::string &_data) {
+    iovec itsVector;
+    itsVector.iov_base = const_cast<char *>(_data.data());
+    itsVector.iov_len = _data.size();
+
+    std::vector<char> itsControl(CMSG_SPACE(sizeof(int) * _fds.size()), 0);
+    msghdr itsMessage;
+    std::memset(&itsMessage, 0, sizeof(itsMessage));
+    itsMessage.msg_iov = &itsVector;
+    itsMessage.msg_iovlen = 1;
+    itsMessage.msg_control = &itsControl[0];
+    itsMessage.msg_controllen = itsControl.size();
+
+    cmsghdr *itsHeader = CMSG_FIRSTHDR(&itsMessage);
+    itsHeader->cmsg_level = SOL_SOCKET;
+    itsHeader->cmsg_type = SCM_RIGHTS;
+    itsHeader->cmsg_len = CMSG_LEN(sizeof(int) * _fds.size());
+    std::memcpy(CMSG_DATA(itsHeader), _fds.data(), sizeof(int) * _fds.size());
+
+    return (sendmsg(_socket, &itsMessage, MSG_NOSIGNAL) == ssize_t(_data.size()));
+}
+
+/*
+ * Receives the file descriptors together with exactly _size bytes of data.
+ */
+static std::vector<int>
+receiveFileDescriptors(int _socket, std::size_t _count, std::string &_data, std::size_t _size) {
+    std::vector<int> itsFds;
+
+    _data.assign(_size, '\0');
+    iovec itsVector;
+    itsVector.iov_base = &_data[0];
+    itsVector.iov_len = _size;
+
+    std::vector<char> itsControl(CMSG_SPACE(sizeof(int) * _count), 0);
+    msghdr itsMessage;
+    std::memset(&itsMessage, 0, sizeof(itsMessage));
+    itsMessage.msg_iov = &itsVector;
+    itsMessage.msg_iovlen = 1;
+    itsMessage.msg_control = &itsControl[0];
+    itsMessage.msg_controllen = itsControl.size();
+
+    ssize_t itsReceived = recvmsg(_socket, &itsMessage, MSG_CMSG_CLOEXEC);
+    if (itsReceived <= 0)
+        return itsFds;
+
+    for (cmsghdr *itsHeader = CMSG_FIRSTHDR(&itsMessage);
+            itsHeader != nullptr;
+            itsHeader = CMSG_NXTHDR(&itsMessage, itsHeader)) {
+        if (itsHeader->cmsg_level == SOL_SOCKET && itsHeader->cmsg_type == SCM_RIGHTS) {
+            std::size_t itsSize = (itsHeader->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            itsFds.resize(itsSize);
+            std::memcpy(&itsFds[0], CMSG_DATA(itsHeader), itsSize * sizeof(int));
+        }
+    }
+
+    // The stream may deliver the data in pieces, the descriptors come
+    // with the first one.
+    std::size_t itsOffset(itsReceived);
+    while (itsOffset < _size && itsReceived > 0) {
+        itsReceived = recv(_socket, &_data[itsOffset], _size - itsOffset, 0);
+        if (itsReceived > 0)
+            itsOffset += std::size_t(itsReceived);
+    }
+
+    if (itsFds.size() != _count || itsOffset < _size) {
+        for (auto fd : itsFds)
+            close(fd);
+        itsFds.clear();
+    }
+    return itsFds;
+}
+
+/*
+ * A registered stub and the channels of its connected clients
+ */
+struct ShmFactory::Service {
+    struct Connection {
+        ~Connection() {
+            context_->deregisterWatch(watch_.get());
+            close(socket_);
+            // Drop the stub adapter together with the connection, even if
+            // it is still referenced elsewhere
+            if (channel_)
+                channel_->setMessageHandler(nullptr);
+        }
+
+        int socket_;
+        // Received part of the hello of the client, the channel is created
+        // once it is complete
+        std::string hello_;
+        std::shared_ptr<ShmChannel> channel_;
+        std::shared_ptr<MainLoopContext> context_;
+        std::unique_ptr<ShmWatch> watch_;
+    };
+
+    Service(const Address &_address, const std::shared_ptr<StubBase> &_stub,
+            StubAdapterCreateFunction _createStubAdapter,
+            std::shared_ptr<MainLoopContext> _context, std::size_t _capacity)
+        : address_(_address), stub_(_stub),
+          createStubAdapter_(_createStubAdapter),
+          context_(_context), capacity_(_capacity), listener_(-1) {
+    }
+
+    ~Service() {
+        if (watch_)
+            context_->deregisterWatch(watch_.get());
+        if (listener_ >= 0)
+            close(listener_);
+
+        // Connections are destroyed without holding the lock, as this
+        // locks their channels.
+        std::map<int, std::shared_ptr<Connection>> itsConnections;
+        {
+            std::lock_guard<std::recursive_mutex> itsLock(mutex_);
+            itsConnections.swap(connections_);
+        }
+    }
+
+    bool listen() {
+        listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (listener_ < 0)
+            return false;
+
+        sockaddr_un itsAddress;
+        socklen_t itsLength = getSocketAddress(address_, itsAddress);
+        if (bind(listener_, reinterpret_cast<sockaddr *>(&itsAddress), itsLength) != 0
+                || ::listen(listener_, SHM_LISTEN_BACKLOG) != 0) {
+            COMMONAPI_ERROR("ShmFactory: cannot offer ", address_, " (", errno, ")");
+            return false;
+        }
+
+        watch_ = std::unique_ptr<ShmWatch>(new ShmWatch(listener_, [this](unsigned int) {
+            accept();
+        }));
+        context_->registerWatch(watch_.get());
+        return true;
+    }
+
+    void accept() {
+        int itsSocket = accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (itsSocket < 0)
+            return;
+
+        if (!isTrustedPeer(itsSocket)) {
+            COMMONAPI_WARNING("ShmFactory: rejected client of another user for ", address_);
+            close(itsSocket);
+            return;
+        }
+
+        std::shared_ptr<Connection> itsConnection = std::make_shared<Connection>();
+        itsConnection->socket_ = itsSocket;
+        itsConnection->context_ = context_;
+        itsConnection->watch_ = std::unique_ptr<ShmWatch>(new ShmWatch(itsSocket, [this, itsSocket](unsigned int) {
+            receive(itsSocket);
+        }));
+        context_->registerWatch(itsConnection->watch_.get());
+
+        std::lock_guard<std::recursive_mutex> itsLock(mutex_);
+        connections_[itsSocket] = itsConnection;
+    }
+
+    // Receives the hello of the client. Afterwards, the client never writes
+    // to the socket, it only becomes readable when the client closes it.
+    void receive(int _socket) {
+        std::shared_ptr<Connection> itsConnection;
+        {
+            std::lock_guard<std::recursive_mutex> itsLock(mutex_);
+            auto foundConnection = connections_.find(_socket);
+            if (foundConnection == connections_.end())
+                return;
+            itsConnection = foundConnection->second;
+        }
+
+        if (itsConnection->channel_) {
+            disconnect(_socket);
+            return;
+        }
+
+        char itsBuffer[256];
+        ssize_t itsReceived = recv(_socket, itsBuffer, sizeof(itsBuffer), 0);
+        if (itsReceived < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return;
+        if (itsReceived <= 0) {
+            disconnect(_socket);
+            return;
+        }
+        itsConnection->hello_.append(itsBuffer, std::size_t(itsReceived));
+
+        ssize_t itsHelloSize = checkHello(itsConnection->hello_, address_);
+        if (itsHelloSize == 0)
+            return;
+        if (itsHelloSize < 0 || std::size_t(itsHelloSize) != itsConnection->hello_.size()) {
+            COMMONAPI_WARNING("ShmFactory: rejected client with invalid hello for ", address_);
+            disconnect(_socket);
+            return;
+        }
+
+        std::shared_ptr<ShmChannel> itsChannel = ShmChannel::create(address_.getAddressRef(), capacity_);
+        if (!itsChannel || !sendFileDescriptors(_socket, itsChannel->getPeerFileDescriptors(),
+                                                getHello(address_))) {
+            COMMONAPI_ERROR("ShmFactory: cannot connect client to ", address_);
+            disconnect(_socket);
+            return;
+        }
+
+        itsChannel->setMessageHandler(createStubAdapter_(address_, stub_, itsChannel));
+        itsChannel->registerWatch(context_);
+        itsConnection->channel_ = itsChannel;
+        itsConnection->hello_.clear();
+    }
+
+    void disconnect(int _socket) {
+        std::shared_ptr<Connection> itsConnection;
+        {
+            std::lock_guard<std::recursive_mutex> itsLock(mutex_);
+            auto foundConnection = connections_.find(_socket);
+            if (foundConnection == connections_.end())
+                return;
+            itsConnection = foundConnection->second;
+            connections_.erase(foundConnection);
+        }
+    }
+
+    Address address_;
+    std::shared_ptr<StubBase> stub_;
+    StubAdapterCreateFunction createStubAdapter_;
+    std::shared_ptr<MainLoopContext> context_;
+    std::size_t capacity_;
+
+    int listener_;
+    std::unique_ptr<ShmWatch> watch_;
+    std::map<int, std::shared_ptr<Connection>> connections_;
+    std::recursive_mutex mutex_;
+};
+
+/*
+ * ShmFactory
+ */
+std::shared_ptr<ShmFactory>
+ShmFactory::get() {
+    static std::shared_ptr<ShmFactory> theFactory = std::make_shared<ShmFactory>();
+    return theFactory;
+}
+
+ShmFactory::ShmFactory()
+    : channelCapacity_(SHM_DEFAULT_CHANNEL_CAPACITY),
+      connectTimeout_(SHM_DEFAULT_CONNECT_TIMEOUT) {
+}
+
+ShmFactory::~ShmFactory() {
+    // Services must be removed from the main loop before it is stopped
+    services_.clear();
+    mainLoop_.reset();
+}
+
+void
+ShmFactory::registerProxyCreateMethod(const std::string &_interface, ProxyCreateFunction _function) {
+    COMMONAPI_DEBUG("Registering shm proxy create method for interface=", _interface);
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    proxyCreateFunctions_[_interface] = _function;
+}
+
+void
+ShmFactory::registerStubAdapterCreateMethod(const std::string &_interface, StubAdapterCreateFunction _function) {
+    COMMONAPI_DEBUG("Registering shm stub adapter create method for interface=", _interface);
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    stubAdapterCreateFunctions_[_interface] = _function;
+}
+
+void
+ShmFactory::setChannelCapacity(std::size_t _capacity) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    channelCapacity_ = _capacity;
+}
+
+void
+ShmFactory::setConnectTimeout(std::chrono::milliseconds _timeout) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    connectTimeout_ = _timeout;
+}
+
+std::shared_ptr<Proxy>
+ShmFactory::createProxy(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                        const ConnectionId_t &_connectionId) {
+    (void)_connectionId;
+    return createShmProxy(Address(_domain, _interface, _instance), getDefaultContext());
+}
+
+std::shared_ptr<Proxy>
+ShmFactory::createProxy(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                        std::shared_ptr<MainLoopContext> _context) {
+    return createShmProxy(Address(_domain, _interface, _instance),
+                          (_context ? _context : getDefaultContext()));
+}
+
+bool
+ShmFactory::registerStub(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                         std::shared_ptr<StubBase> _stub, const ConnectionId_t &_connectionId) {
+    (void)_connectionId;
+    return addService(Address(_domain, _interface, _instance), _stub, getDefaultContext());
+}
+
+bool
+ShmFactory::registerStub(const std::string &_domain, const std::string &_interface, const std::string &_instance,
+                         std::shared_ptr<StubBase> _stub, std::shared_ptr<MainLoopContext> _context) {
+    return addService(Address(_domain, _interface, _instance), _stub,
+                      (_context ? _context : getDefaultContext()));
+}
+
+bool
+ShmFactory::unregisterStub(const std::string &_domain, const std::string &_interface, const std::string &_instance) {
+    // The service is destroyed after releasing the lock, as this waits
+    // for its watches to be removed from the main loop.
+    std::shared_ptr<Service> itsService;
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        auto foundService = services_.find(Address(_domain, _interface, _instance));
+        if (foundService == services_.end())
+            return false;
+        itsService = foundService->second;
+        services_.erase(foundService);
+    }
+    return true;
+}
+
+std::shared_ptr<Proxy>
+ShmFactory::createShmProxy(const Address &_address, std::shared_ptr<MainLoopContext> _context) {
+    ProxyCreateFunction itsFunction;
+    std::chrono::milliseconds itsTimeout;
+    {
+        std::lock_guard<std::mutex> itsLock(mutex_);
+        auto foundFunction = proxyCreateFunctions_.find(_address.getInterface());
+        if (foundFunction == proxyCreateFunctions_.end())
+            return nullptr;
+        itsFunction = foundFunction->second;
+        itsTimeout = connectTimeout_;
+    }
+
+    int itsSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (itsSocket < 0)
+        return nullptr;
+
+    sockaddr_un itsAddress;
+    socklen_t itsLength = getSocketAddress(_address, itsAddress);
+    if (connect(itsSocket, reinterpret_cast<sockaddr *>(&itsAddress), itsLength) != 0) {
+        COMMONAPI_DEBUG("ShmFactory: ", _address, " is not offered");
+        close(itsSocket);
+        return nullptr;
+    }
+
+    if (!isTrustedPeer(itsSocket)) {
+        COMMONAPI_WARNING("ShmFactory: ", _address, " is offered by another user");
+        close(itsSocket);
+        return nullptr;
+    }
+
+    timeval itsSocketTimeout;
+    itsSocketTimeout.tv_sec = time_t(itsTimeout.count() / 1000);
+    itsSocketTimeout.tv_usec = suseconds_t((itsTimeout.count() % 1000) * 1000);
+    (void)setsockopt(itsSocket, SOL_SOCKET, SO_RCVTIMEO, &itsSocketTimeout, sizeof(itsSocketTimeout));
+    (void)setsockopt(itsSocket, SOL_SOCKET, SO_SNDTIMEO, &itsSocketTimeout, sizeof(itsSocketTimeout));
+
+    std::string itsHello(getHello(_address));
+    if (send(itsSocket, itsHello.data(), itsHello.size(), MSG_NOSIGNAL) != ssize_t(itsHello.size())) {
+        COMMONAPI_ERROR("ShmFactory: cannot connect to ", _address, " (", errno, ")");
+        close(itsSocket);
+        return nullptr;
+    }
+
+    // The service answers with the same hello, a service of another
+    // address whose name has the same hash does not.
+    std::string itsReply;
+    std::vector<int> itsFds = receiveFileDescriptors(itsSocket, ShmChannel::FILE_DESCRIPTORS,
+                                                     itsReply, itsHello.size());
+    if (!itsFds.empty() && checkHello(itsReply, _address) != ssize_t(itsHello.size())) {
+        COMMONAPI_WARNING("ShmFactory: ", _address, " answered with an invalid hello");
+        for (auto fd : itsFds)
+            close(fd);
+        itsFds.clear();
+    }
+
+    std::shared_ptr<ShmChannel> itsChannel = ShmChannel::attach(itsFds, itsSocket);
+    if (!itsChannel) {
+        COMMONAPI_ERROR("ShmFactory: cannot attach to channel of ", _address);
+        return nullptr;
+    }
+
+    // Let the proxy install its message handler before dispatching starts
+    std::shared_ptr<Proxy> itsProxy = itsFunction(_address, itsChannel);
+    if (itsProxy)
+        itsChannel->registerWatch(_context);
+    return itsProxy;
+}
+
+bool
+ShmFactory::addService(const Address &_address, const std::shared_ptr<StubBase> &_stub,
+                       std::shared_ptr<MainLoopContext> _context) {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    auto foundFunction = stubAdapterCreateFunctions_.find(_address.getInterface());
+    if (foundFunction == stubAdapterCreateFunctions_.end())
+        return false;
+
+    if (services_.find(_address) != services_.end())
+        return false;
+
+    std::shared_ptr<Service> itsService = std::make_shared<Service>(
+            _address, _stub, foundFunction->second, _context, channelCapacity_);
+    if (!itsService->listen())
+        return false;
+
+    services_[_address] = itsService;
+    return true;
+}
+
+std::shared_ptr<MainLoopContext>
+ShmFactory::getDefaultContext() {
+    std::lock_guard<std::mutex> itsLock(mutex_);
+    if (!mainLoop_)
+        mainLoop_ = std::unique_ptr<ShmMainLoop>(new ShmMainLoop());
+    return mainLoop_->getContext();
+}
+
+} // namespace CommonAPI
+
+#endif // !WIN32
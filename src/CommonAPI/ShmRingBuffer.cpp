@@ -0,0 +1,246 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <CommonAPI/Logger.hpp>
+#include <CommonAPI/ShmRingBuffer.hpp>
+
+namespace CommonAPI {
+
+static const uint32_t SHM_RING_MAGIC = 0x43415052; // "CAPR"
+static const uint32_t SHM_FRAME_PADDING = 0xFFFFFFFF;
+static const std::size_t SHM_FRAME_HEADER_SIZE = 8;
+static const std::size_t SHM_HEADER_SIZE = 4096;
+static const std::size_t SHM_MINIMUM_CAPACITY = 4096;
+
+// A peer that shrinks the memory file would make accesses raise SIGBUS
+static const int SHM_SEALS = (F_SEAL_SHRINK | F_SEAL_GROW);
+
+/*
+ * Positions are counted in bytes since creation and never wrap. Each
+ * message consists of a frame header holding the payload size and the
+ * payload, padded to a multiple of 8 bytes. If a message does not fit
+ * into the remaining space at the end of the buffer, a padding frame is
+ * written and the message starts at the beginning again.
+ */
+struct ShmRingBuffer::Header {
+    uint32_t magic_;
+    uint32_t padding_;
+    uint64_t capacity_;
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+};
+
+static inline uint64_t
+getFrameSize(uint64_t _payload) {
+    return ((SHM_FRAME_HEADER_SIZE + _payload + 7) & ~uint64_t(7));
+}
+
+std::shared_ptr<ShmRingBuffer>
+ShmRingBuffer::create(const std::string &_name, std::size_t _capacity) {
+    std::size_t itsCapacity(SHM_MINIMUM_CAPACITY);
+    while (itsCapacity < _capacity)
+        itsCapacity <<= 1;
+
+    int itsFd = memfd_create(_name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (itsFd < 0) {
+        COMMONAPI_ERROR("ShmRingBuffer: cannot create memory file \"", _name, "\" (", errno, ")");
+        return nullptr;
+    }
+    if (ftruncate(itsFd, off_t(SHM_HEADER_SIZE + itsCapacity)) != 0) {
+        COMMONAPI_ERROR("ShmRingBuffer: cannot resize memory file \"", _name, "\" (", errno, ")");
+        close(itsFd);
+        return nullptr;
+    }
+    if (fcntl(itsFd, F_ADD_SEALS, SHM_SEALS) != 0) {
+        COMMONAPI_ERROR("ShmRingBuffer: cannot seal memory file \"", _name, "\" (", errno, ")");
+        close(itsFd);
+        return nullptr;
+    }
+
+    std::shared_ptr<ShmRingBuffer> itsBuffer = map(itsFd);
+    if (itsBuffer) {
+        Header *itsHeader = itsBuffer->header_;
+        itsHeader->magic_ = SHM_RING_MAGIC;
+        itsHeader->capacity_ = itsCapacity;
+        itsHeader->head_.store(0, std::memory_order_relaxed);
+        itsHeader->tail_.store(0, std::memory_order_release);
+    }
+    return itsBuffer;
+}
+
+std::shared_ptr<ShmRingBuffer>
+ShmRingBuffer::attach(int _fd) {
+    int itsSeals = fcntl(_fd, F_GET_SEALS);
+    if (itsSeals < 0 || (itsSeals & SHM_SEALS) != SHM_SEALS) {
+        COMMONAPI_ERROR("ShmRingBuffer: memory file is not sealed");
+        close(_fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<ShmRingBuffer> itsBuffer = map(_fd);
+    if (itsBuffer && itsBuffer->header_->magic_ != SHM_RING_MAGIC) {
+        COMMONAPI_ERROR("ShmRingBuffer: invalid memory file");
+        return nullptr;
+    }
+    return itsBuffer;
+}
+
+std::shared_ptr<ShmRingBuffer>
+ShmRingBuffer::map(int _fd) {
+    struct stat itsStat;
+    if (fstat(_fd, &itsStat) != 0
+            || std::size_t(itsStat.st_size) < SHM_HEADER_SIZE + SHM_MINIMUM_CAPACITY) {
+        close(_fd);
+        return nullptr;
+    }
+
+    std::size_t itsCapacity(std::size_t(itsStat.st_size) - SHM_HEADER_SIZE);
+    if (0 != (itsCapacity & (itsCapacity - 1))) {
+        close(_fd);
+        return nullptr;
+    }
+
+    void *itsMemory = mmap(nullptr, std::size_t(itsStat.st_size),
+                           PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (MAP_FAILED == itsMemory) {
+        COMMONAPI_ERROR("ShmRingBuffer: cannot map memory file (", errno, ")");
+        close(_fd);
+        return nullptr;
+    }
+
+    return std::shared_ptr<ShmRingBuffer>(new ShmRingBuffer(_fd, itsMemory, itsCapacity));
+}
+
+ShmRingBuffer::ShmRingBuffer(int _fd, void *_memory, std::size_t _capacity)
+    : fd_(_fd),
+      header_(static_cast<Header *>(_memory)),
+      data_(static_cast<uint8_t *>(_memory) + SHM_HEADER_SIZE),
+      capacity_(_capacity),
+      reserved_(0),
+      peeked_(0) {
+}
+
+ShmRingBuffer::~ShmRingBuffer() {
+    munmap(header_, SHM_HEADER_SIZE + capacity_);
+    close(fd_);
+}
+
+int
+ShmRingBuffer::getFileDescriptor() const {
+    return fd_;
+}
+
+std::size_t
+ShmRingBuffer::getCapacity() const {
+    return capacity_;
+}
+
+std::size_t
+ShmRingBuffer::getMaximumMessageSize() const {
+    return (capacity_ / 2 - SHM_FRAME_HEADER_SIZE);
+}
+
+uint8_t *
+ShmRingBuffer::reserve(std::size_t _size, std::size_t &_available) {
+    if (_size > getMaximumMessageSize())
+        return nullptr;
+
+    uint64_t itsHead = header_->head_.load(std::memory_order_relaxed);
+    uint64_t itsTail = header_->tail_.load(std::memory_order_acquire);
+    uint64_t itsFree = capacity_ - (itsHead - itsTail);
+    uint64_t itsOffset = (itsHead & (capacity_ - 1));
+    uint64_t itsContiguous = capacity_ - itsOffset;
+
+    if (getFrameSize(_size) > itsContiguous) {
+        // Skip the end of the buffer if the reader already left it
+        if (itsFree < itsContiguous + getFrameSize(_size))
+            return nullptr;
+
+        uint32_t itsPadding(SHM_FRAME_PADDING);
+        std::memcpy(data_ + itsOffset, &itsPadding, sizeof(itsPadding));
+        itsHead += itsContiguous;
+        header_->head_.store(itsHead, std::memory_order_release);
+
+        itsFree -= itsContiguous;
+        itsOffset = 0;
+        itsContiguous = capacity_;
+    }
+
+    uint64_t itsSpace = std::min(itsFree, itsContiguous);
+    if (itsSpace < getFrameSize(_size))
+        return nullptr;
+
+    reserved_ = itsSpace;
+    _available = std::size_t(itsSpace - SHM_FRAME_HEADER_SIZE);
+    return (data_ + itsOffset + SHM_FRAME_HEADER_SIZE);
+}
+
+void
+ShmRingBuffer::commit(std::size_t _size) {
+    if (0 == reserved_ || getFrameSize(_size) > reserved_)
+        return;
+
+    uint64_t itsHead = header_->head_.load(std::memory_order_relaxed);
+    uint32_t itsSize(static_cast<uint32_t>(_size));
+    std::memcpy(data_ + (itsHead & (capacity_ - 1)), &itsSize, sizeof(itsSize));
+    header_->head_.store(itsHead + getFrameSize(_size), std::memory_order_release);
+    reserved_ = 0;
+}
+
+bool
+ShmRingBuffer::peek(const uint8_t *&_data, std::size_t &_size) {
+    for (;;) {
+        uint64_t itsTail = header_->tail_.load(std::memory_order_relaxed);
+        uint64_t itsHead = header_->head_.load(std::memory_order_acquire);
+        if (itsTail == itsHead)
+            return false;
+
+        uint64_t itsOffset = (itsTail & (capacity_ - 1));
+        uint32_t itsSize;
+        std::memcpy(&itsSize, data_ + itsOffset, sizeof(itsSize));
+        if (SHM_FRAME_PADDING == itsSize) {
+            header_->tail_.store(itsTail + (capacity_ - itsOffset), std::memory_order_release);
+            continue;
+        }
+
+        // Do not trust the other process
+        if (getFrameSize(itsSize) > itsHead - itsTail
+                || getFrameSize(itsSize) > capacity_ - itsOffset) {
+            COMMONAPI_ERROR("ShmRingBuffer: corrupt message, dropping buffer content");
+            header_->tail_.store(itsHead, std::memory_order_release);
+            return false;
+        }
+
+        peeked_ = getFrameSize(itsSize);
+        _data = data_ + itsOffset + SHM_FRAME_HEADER_SIZE;
+        _size = itsSize;
+        return true;
+    }
+}
+
+void
+ShmRingBuffer::release() {
+    if (0 == peeked_)
+        return;
+
+    uint64_t itsTail = header_->tail_.load(std::memory_order_relaxed);
+    header_->tail_.store(itsTail + peeked_, std::memory_order_release);
+    peeked_ = 0;
+}
+
+} // namespace CommonAPI
+
+#endif // !WIN32
@@ -0,0 +1,99 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include <CommonAPI/Stub.hpp>
+
+namespace CommonAPI {
+
+/*
+ * Executors of the stubs that have one. Most stubs do not, calls to them
+ * only check the number of entries. Calls to the others read the current
+ * table by std::atomic_load. Writers replace it by a modified copy under
+ * executorsMutex__.
+ *
+ * Entries are keyed by address. An entry left by a stub that did not
+ * remove it would be found by the next stub at that address, so entries
+ * that know their stub are ignored once it expired and dropped on the next
+ * change.
+ */
+struct ExecutorEntry {
+    std::shared_ptr<Executor> executor_;
+    std::weak_ptr<const StubBase> self_;
+    bool isOwned_;
+};
+
+typedef std::unordered_map<const StubBase *, ExecutorEntry> Executors;
+
+static std::shared_ptr<const Executors> executors__(std::make_shared<Executors>());
+static std::atomic<std::size_t> executorsSize__(0);
+static std::mutex executorsMutex__;
+
+static void
+setExecutor(const StubBase *_stub, const ExecutorEntry &_entry) {
+    if (!_entry.executor_ && 0 == executorsSize__.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> itsLock(executorsMutex__);
+    std::shared_ptr<const Executors> itsCurrent = std::atomic_load(&executors__);
+    if (!_entry.executor_ && itsCurrent->find(_stub) == itsCurrent->end())
+        return;
+
+    std::shared_ptr<Executors> itsExecutors = std::make_shared<Executors>();
+    for (auto &entry : *itsCurrent) {
+        if (entry.first != _stub && !(entry.second.isOwned_ && entry.second.self_.expired()))
+            itsExecutors->insert(entry);
+    }
+    if (_entry.executor_)
+        (*itsExecutors)[_stub] = _entry;
+    std::atomic_store(&executors__, std::shared_ptr<const Executors>(itsExecutors));
+    executorsSize__.store(itsExecutors->size(), std::memory_order_release);
+}
+
+void
+StubBase::setExecutor(std::shared_ptr<Executor> _executor) {
+    ExecutorEntry itsEntry;
+    itsEntry.executor_ = _executor;
+    itsEntry.isOwned_ = false;
+    CommonAPI::setExecutor(this, itsEntry);
+}
+
+void
+StubBase::setExecutor(std::shared_ptr<Executor> _executor,
+                      const std::weak_ptr<const StubBase> &_self) {
+    ExecutorEntry itsEntry;
+    itsEntry.executor_ = _executor;
+    itsEntry.self_ = _self;
+    itsEntry.isOwned_ = true;
+    CommonAPI::setExecutor(this, itsEntry);
+}
+
+std::shared_ptr<Executor>
+StubBase::getExecutor() const {
+    if (0 == executorsSize__.load(std::memory_order_acquire))
+        return nullptr;
+
+    std::shared_ptr<const Executors> itsExecutors = std::atomic_load(&executors__);
+    auto foundExecutor = itsExecutors->find(this);
+    if (foundExecutor != itsExecutors->end()
+            && !(foundExecutor->second.isOwned_ && foundExecutor->second.self_.expired()))
+        return foundExecutor->second.executor_;
+    return nullptr;
+}
+
+bool
+StubBase::execute(const std::shared_ptr<ClientId> &_client, std::size_t _method,
+                  std::function<void()> _task) {
+    std::shared_ptr<Executor> itsExecutor = getExecutor();
+    if (itsExecutor)
+        return itsExecutor->execute(_client, _method, std::move(_task));
+    _task();
+    return true;
+}
+
+} // namespace CommonAPI
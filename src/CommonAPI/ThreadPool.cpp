@@ -0,0 +1,107 @@
+// Copyright (C) 2015 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include <CommonAPI/ThreadPool.hpp>
+
+namespace CommonAPI {
+
+struct ThreadPool::Queue {
+    Queue() : isRunning_(true), isStopped_(false) {}
+
+    std::deque<Task> tasks_;
+    bool isRunning_;
+    bool isStopped_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+ThreadPool::ThreadPool(std::size_t _threads)
+    : queue_(std::make_shared<Queue>()) {
+    if (_threads == 0)
+        _threads = 1;
+
+    for (std::size_t i = 0; i < _threads; i++)
+        threads_.push_back(std::thread(&ThreadPool::run, queue_));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> itsLock(queue_->mutex_);
+        queue_->isRunning_ = false;
+    }
+    queue_->condition_.notify_all();
+
+    join();
+}
+
+void
+ThreadPool::post(Task _task) {
+    {
+        std::lock_guard<std::mutex> itsLock(queue_->mutex_);
+        if (queue_->isStopped_)
+            return;
+        queue_->tasks_.push_back(std::move(_task));
+    }
+    queue_->condition_.notify_one();
+}
+
+void
+ThreadPool::stop() {
+    // Destroy the dropped tasks outside the lock, they may post again
+    std::deque<Task> itsTasks;
+    {
+        std::lock_guard<std::mutex> itsLock(queue_->mutex_);
+        queue_->isStopped_ = true;
+        queue_->isRunning_ = false;
+        itsTasks.swap(queue_->tasks_);
+    }
+    queue_->condition_.notify_all();
+    itsTasks.clear();
+
+    join();
+}
+
+void
+ThreadPool::join() {
+    for (auto &thread : threads_) {
+        if (!thread.joinable())
+            continue;
+        if (thread.get_id() == std::this_thread::get_id()) {
+            thread.detach();
+        } else {
+            thread.join();
+        }
+    }
+}
+
+std::size_t
+ThreadPool::getThreadCount() const {
+    return threads_.size();
+}
+
+void
+ThreadPool::run(std::shared_ptr<Queue> _queue) {
+    std::unique_lock<std::mutex> itsLock(_queue->mutex_);
+    while (true) {
+        _queue->condition_.wait(itsLock,
+            [&_queue]() { return (!_queue->isRunning_ || !_queue->tasks_.empty()); });
+        if (_queue->tasks_.empty())
+            break;
+
+        Task itsTask = std::move(_queue->tasks_.front());
+        _queue->tasks_.pop_front();
+
+        itsLock.unlock();
+        itsTask();
+        itsLock.lock();
+    }
+}
+
+} // namespace CommonAPI